@@ -0,0 +1,971 @@
+// 装甲板检测各阶段微基准测试
+//
+// 用合成图像分别计时 preprocess、findLights、determineColor、matchLights（含 isArmor）、
+// PnPSolver::solvePnP（OpenCV IPPE）与 solvePlanar/solveBatch/solveTracked（闭式平面 PnP / 整帧批量 / 按轨迹热启动）、KalmanFilter::predict/update、ImmKalmanFilter、BatchedKalmanFilter（32 个目标）、
+// RobotEkf（整车 EKF）、BallisticSolver（查表 vs 逐步积分）、去畸变（cv::undistort vs 缓存映射表的 remap）、
+// CoordinateTransformer 批量投影/反投影（512 点，反投影含去畸变）、按帧时间戳插值云台姿态（ImuPoseBuffer）和 Tracker::update，
+// 以及完整的 Detector::detect；另外检查稳态每帧堆分配次数（RM_COUNT_ALLOCATIONS）。结果可写成 JSON，并与基线 JSON 对比。
+//
+// 用法：
+//   rm_vision_benchmark [--resolutions 640x480,1920x1080] [--lights 4,8,16]
+//                       [--clutter 0,1,2] [--iterations 200]
+//                       [--json result.json] [--baseline baseline.json]
+//   rm_vision_benchmark --checks-only --require-alloc-count   （ctest：只跑一致性/分配检查）
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "armor_detector/alloc_counter.hpp"
+#include "armor_detector/ballistic_solver.hpp"
+#include "armor_detector/batched_kalman_filter.hpp"
+#include "armor_detector/camera_calibrator.hpp"
+#include "armor_detector/camera_model.hpp"
+#include "armor_detector/coordinate_transformer.hpp"
+#include "armor_detector/detector.hpp"
+#include "armor_detector/imm_filter.hpp"
+#include "armor_detector/imu_pose_buffer.hpp"
+#include "armor_detector/kalman_filter.hpp"
+#include "armor_detector/pnp_solver.hpp"
+#include "armor_detector/robot_ekf.hpp"
+#include "armor_detector/tracker.hpp"
+
+using namespace rm_auto_aim;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct BenchCase {
+    cv::Size resolution;
+    int light_count = 8;
+    int clutter = 0;   // 0：干净背景；越大噪声与干扰色块越多
+
+    std::string name() const {
+        std::ostringstream ss;
+        ss << resolution.width << "x" << resolution.height << "_l" << light_count << "_c" << clutter;
+        return ss.str();
+    }
+};
+
+struct StageResult {
+    std::string stage;
+    std::size_t samples = 0;
+    double mean_us = 0.0;
+    double median_us = 0.0;
+    double p99_us = 0.0;
+    double min_us = 0.0;
+    double stddev_us = 0.0;
+};
+
+struct CaseResult {
+    BenchCase bench_case;
+    int armors_found = 0;
+    std::vector<StageResult> stages;
+};
+
+double elapsedUs(Clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+StageResult summarize(const std::string& stage, std::vector<double> samples) {
+    StageResult result;
+    result.stage = stage;
+    result.samples = samples.size();
+    if (samples.empty()) {
+        return result;
+    }
+
+    std::sort(samples.begin(), samples.end());
+    double sum = 0.0;
+    for (double s : samples) sum += s;
+    result.mean_us = sum / samples.size();
+
+    double var = 0.0;
+    for (double s : samples) var += (s - result.mean_us) * (s - result.mean_us);
+    result.stddev_us = std::sqrt(var / samples.size());
+
+    result.min_us = samples.front();
+    result.median_us = samples[samples.size() / 2];
+    result.p99_us = samples[std::min(samples.size() - 1, samples.size() * 99 / 100)];
+    return result;
+}
+
+// 画一根灯条：中心、长度、倾角（度），颜色为 BGR
+void drawLight(cv::Mat& img, const cv::Point2f& center, float length, float angle,
+               const cv::Scalar& color) {
+    cv::RotatedRect rect(center, cv::Size2f(length * 0.22f, length), angle);
+    cv::Point2f pts[4];
+    rect.points(pts);
+    cv::Point poly[4];
+    for (int i = 0; i < 4; ++i) {
+        poly[i] = cv::Point(cvRound(pts[i].x), cvRound(pts[i].y));
+    }
+    cv::fillConvexPoly(img, poly, 4, color);
+}
+
+// 生成合成帧：light_count 根目标色灯条按装甲板成对排布，
+// clutter 控制高斯噪声幅度、异色灯条与随机色块数量
+cv::Mat makeFrame(const BenchCase& bench_case, unsigned seed) {
+    cv::RNG rng(seed);
+    cv::Mat frame(bench_case.resolution, CV_8UC3, cv::Scalar(20, 20, 20));
+
+    const int width = bench_case.resolution.width;
+    const int height = bench_case.resolution.height;
+
+    if (bench_case.clutter > 0) {
+        cv::Mat noise(frame.size(), CV_8UC3);
+        cv::randn(noise, cv::Scalar::all(0), cv::Scalar::all(6.0 * bench_case.clutter));
+        cv::add(frame, noise, frame);
+
+        // 随机色块（含与目标色相近的块，会产生需要被过滤的轮廓）
+        const int blobs = 15 * bench_case.clutter;
+        for (int i = 0; i < blobs; ++i) {
+            cv::Point center(rng.uniform(0, width), rng.uniform(0, height));
+            cv::Size axes(rng.uniform(3, width / 30 + 4), rng.uniform(3, height / 30 + 4));
+            cv::Scalar color(rng.uniform(0, 256), rng.uniform(0, 256), rng.uniform(0, 256));
+            cv::ellipse(frame, center, axes, rng.uniform(0, 180), 0, 360, color, -1);
+        }
+    }
+
+    // 灯条布置在网格中，每格一对（最后可能剩一根单独的）
+    const float length = height / 10.0f;
+    const int pairs = (bench_case.light_count + 1) / 2;
+    const int cols = std::max(1, static_cast<int>(std::ceil(std::sqrt(pairs * 1.5))));
+    const int rows = (pairs + cols - 1) / cols;
+    const float cell_w = static_cast<float>(width) / cols;
+    const float cell_h = static_cast<float>(height) / std::max(rows, 1);
+    const float cell_length = std::min(length, cell_h * 0.6f);
+    const cv::Scalar red(40, 40, 255);
+
+    int drawn = 0;
+    for (int p = 0; p < pairs; ++p) {
+        cv::Point2f cell_center((p % cols + 0.5f) * cell_w, (p / cols + 0.5f) * cell_h);
+        float half_gap = std::min(cell_length * 1.2f, cell_w * 0.4f);
+        float angle = rng.uniform(-8.0f, 8.0f);
+
+        drawLight(frame, cell_center - cv::Point2f(half_gap, 0), cell_length, angle, red);
+        if (++drawn < bench_case.light_count) {
+            drawLight(frame, cell_center + cv::Point2f(half_gap, 0), cell_length, angle, red);
+            ++drawn;
+        }
+    }
+
+    // 干扰：异色（蓝色）灯条
+    for (int i = 0; i < bench_case.clutter * 4; ++i) {
+        cv::Point2f center(rng.uniform(0.0f, static_cast<float>(width)),
+                           rng.uniform(0.0f, static_cast<float>(height)));
+        drawLight(frame, center, cell_length * rng.uniform(0.5f, 1.0f),
+                  rng.uniform(-30.0f, 30.0f), cv::Scalar(255, 80, 40));
+    }
+
+    return frame;
+}
+
+// 建表并报告耗时与表大小（BallisticSolver 本身不输出日志）
+BallisticSolver buildBallisticSolver() {
+    const auto start = Clock::now();
+    BallisticSolver solver;
+    std::cout << "[BALLISTIC] Tables built in " << std::setprecision(4) << elapsedUs(start) / 1000.0
+              << " ms (" << solver.tableBytes() / 1024 << " KiB)" << std::endl;
+    return solver;
+}
+
+// 建表约数百毫秒，所有用例共用一个解算器
+const BallisticSolver& ballisticSolver() {
+    static const BallisticSolver solver = buildBallisticSolver();
+    return solver;
+}
+
+// 查表解与参考积分器（RK4 + 二分）在随机目标上的偏差
+void checkBallisticAccuracy(int queries) {
+    const BallisticSolver& solver = ballisticSolver();
+    const BallisticParams& params = solver.getParams();
+    cv::RNG rng(7);
+
+    int compared = 0, mismatched = 0;
+    double max_pitch_err = 0.0, max_miss = 0.0, max_time_err = 0.0;
+    for (int i = 0; i < queries; ++i) {
+        const double distance = rng.uniform(1.0, 20.0);
+        const double height = rng.uniform(-1.0, 2.0);
+        const double speed = rng.uniform(12.0, 30.0);
+        const BallisticSolution fast = solver.solve(distance, height, speed);
+        const BallisticSolution ref = BallisticSolver::solveReference(params, distance, height, speed);
+        if (!fast.valid || !ref.valid) {
+            mismatched += fast.valid != ref.valid;
+            continue;
+        }
+
+        // 用查表得到的 pitch 实际积分一次，看落点高度偏差
+        double hit_height = 0.0, hit_time = 0.0;
+        BallisticSolver::simulate(params, speed, fast.pitch, distance, hit_height, hit_time);
+        max_pitch_err = std::max(max_pitch_err, static_cast<double>(std::abs(fast.pitch - ref.pitch)));
+        max_miss = std::max(max_miss, std::abs(hit_height - height));
+        max_time_err = std::max(max_time_err, static_cast<double>(std::abs(fast.flight_time - ref.flight_time)));
+        compared++;
+    }
+
+    std::cout << "[BALLISTIC] " << compared << " queries vs reference: max pitch err "
+              << std::setprecision(3) << max_pitch_err * 1e3 << " mrad, max miss "
+              << max_miss * 1e3 << " mm, max flight time err " << max_time_err * 1e3 << " ms, "
+              << mismatched << " solvable only by one side (reachability edge)" << std::endl;
+}
+
+// 稳态堆分配（需以 -DRM_COUNT_ALLOCATIONS=ON 构建）：关闭 OpenCV 线程池，单线程对同一帧反复检测，
+// 预热后逐帧统计各阶段的分配次数。preprocess（融合掩码 + 3x3 形态学）与 matchLights 只使用复用的
+// 工作区，须为 0。已知的剩余分配：
+//   findLights - cv::findContours 内部的轮廓点存储（CvMemStorage）与输出数组，次数随轮廓数变化
+//   detect     - 即上面的 findContours，整帧检测不得超过 findLights 的次数；多线程运行时还有 OpenCV
+//                线程池派发，本检查已关闭线程池
+// require 为 true（ctest 目标）时，未编译计数支持视为失败而不是跳过。
+bool checkSteadyStateAllocations(bool require) {
+    if (!alloc_counter::enabled()) {
+        if (require) {
+            std::cerr << "[ERROR] Allocation counting required but not compiled in (RM_COUNT_ALLOCATIONS)"
+                      << std::endl;
+            return false;
+        }
+        std::cout << "[ALLOC] Allocation counting not compiled in (configure with -DRM_COUNT_ALLOCATIONS=ON)"
+                  << std::endl;
+        return true;
+    }
+
+    const int previous_threads = cv::getNumThreads();
+    cv::setNumThreads(0);
+
+    BenchCase bench_case;
+    bench_case.resolution = cv::Size(640, 480);
+    bench_case.clutter = 1;
+    const cv::Mat frame = makeFrame(bench_case, 4242u);
+
+    DetectorParams params;
+    params.log_frames = false;
+    params.roi.enable = false;
+    Detector detector(params);
+    std::vector<Light> lights;
+    std::vector<Armor> armors;
+
+    // 各阶段每帧分配次数的最小/最大值：preprocess, findLights, matchLights, detect
+    const char* names[4] = {"preprocess", "findLights", "matchLights", "detect"};
+    std::size_t lo[4], hi[4];
+    std::fill(lo, lo + 4, std::numeric_limits<std::size_t>::max());
+    std::fill(hi, hi + 4, 0);
+    const int warmup = 10, frames = 50;
+    for (int it = -warmup; it < frames; ++it) {
+        std::size_t counts[4];
+        std::size_t before = alloc_counter::count();
+        cv::Mat binary = detector.preprocess(frame);
+        counts[0] = alloc_counter::count() - before;
+
+        before = alloc_counter::count();
+        detector.findLights(frame, binary, lights);
+        counts[1] = alloc_counter::count() - before;
+
+        before = alloc_counter::count();
+        detector.matchLights(lights, armors);
+        counts[2] = alloc_counter::count() - before;
+
+        detector.detect(frame);
+        counts[3] = detector.getDebugInfo().allocations;
+
+        if (it < 0) continue;
+        for (int s = 0; s < 4; ++s) {
+            lo[s] = std::min(lo[s], counts[s]);
+            hi[s] = std::max(hi[s], counts[s]);
+        }
+    }
+    cv::setNumThreads(previous_threads);
+
+    std::cout << "[ALLOC] Steady-state allocations per frame (" << bench_case.name() << ", single thread):";
+    for (int s = 0; s < 4; ++s) {
+        std::cout << " " << names[s] << " " << lo[s];
+        if (hi[s] != lo[s]) std::cout << ".." << hi[s];
+    }
+    std::cout << std::endl;
+
+    bool ok = true;
+#ifdef RM_FUSED_COLOR_MASK
+    if (hi[0] != 0) {
+        std::cerr << "[ERROR] preprocess allocates in steady state (" << hi[0] << " per frame)" << std::endl;
+        ok = false;
+    }
+#endif
+    if (hi[2] != 0) {
+        std::cerr << "[ERROR] matchLights allocates in steady state (" << hi[2] << " per frame)" << std::endl;
+        ok = false;
+    }
+    // 整帧检测只允许 findContours 的分配（非融合掩码构建时再加上 preprocess 的临时 Mat）
+#ifdef RM_FUSED_COLOR_MASK
+    const std::size_t detect_limit = hi[1];
+#else
+    const std::size_t detect_limit = hi[0] + hi[1];
+#endif
+    if (hi[3] > detect_limit) {
+        std::cerr << "[ERROR] detect allocates beyond findContours in steady state (" << hi[3] << " > "
+                  << detect_limit << " per frame)" << std::endl;
+        ok = false;
+    }
+    return ok;
+}
+
+// BatchedKalmanFilter 的 SIMD 实现（AVX2 / NEON）与标量实现须逐位一致。
+// 目标数取 37（不是 8 的倍数，同时覆盖向量主体与标量尾部），随机帧间隔与随机的测量子集，中途删除/新增目标
+bool checkBatchedKalmanConsistency() {
+    constexpr int targets = 37;
+    constexpr int frames = 200;
+    BatchedKalmanFilter simd(targets, true), scalar(targets, false);
+    cv::RNG rng(13);
+    for (int i = 0; i < targets; ++i) {
+        const cv::Point2f p(rng.uniform(0.0f, 1280.0f), rng.uniform(0.0f, 720.0f));
+        simd.add(p);
+        scalar.add(p);
+    }
+
+    int mismatches = 0;
+    for (int f = 0; f < frames; ++f) {
+        const float dt = rng.uniform(0.005f, 0.05f);
+        simd.predict(dt);
+        scalar.predict(dt);
+        for (int i = 0; i < targets; ++i) {
+            if (rng.uniform(0, 4) == 0) continue;   // 约四分之一的目标本帧没有测量
+            const cv::Point2f z = simd.position(i) + cv::Point2f(rng.gaussian(3.0), rng.gaussian(3.0));
+            simd.setMeasurement(i, z);
+            scalar.setMeasurement(i, z);
+        }
+        simd.update();
+        scalar.update();
+        if (f % 50 == 49) {
+            const int i = rng.uniform(0, targets);
+            simd.remove(i);
+            scalar.remove(i);
+            const cv::Point2f p(rng.uniform(0.0f, 1280.0f), rng.uniform(0.0f, 720.0f));
+            simd.add(p);
+            scalar.add(p);
+        }
+
+        for (int i = 0; i < targets; ++i) {
+            const cv::Point2f a[3] = {simd.position(i), simd.velocity(i), simd.innovationVariance(i)};
+            const cv::Point2f b[3] = {scalar.position(i), scalar.velocity(i), scalar.innovationVariance(i)};
+            mismatches += std::memcmp(a, b, sizeof(a)) != 0;
+        }
+    }
+
+    if (mismatches > 0) {
+        std::cerr << "[ERROR] BatchedKalmanFilter: SIMD and scalar results differ in " << mismatches
+                  << " target-frames" << std::endl;
+        return false;
+    }
+    std::cout << "[BATCHED_KF] SIMD and scalar results bit-identical over " << targets << " targets x "
+              << frames << " frames" << std::endl;
+    return true;
+}
+
+// 匀速移动的单个目标应在 tracking_thres_ 帧后进入 TRACKING 并保持
+bool checkTrackerConfirmation() {
+    bool ok = true;
+    for (Tracker::FilterType filter_type : {Tracker::KALMAN_FILTER, Tracker::IMM_FILTER}) {
+        Tracker tracker(filter_type);
+        const int threshold = tracker.getTrackingThreshold();
+        const int frames = threshold + 20;
+
+        int confirmed_at = -1;
+        bool dropped = false;
+        for (int i = 1; i <= frames; ++i) {
+            Armor armor;
+            armor.type = ArmorType::SMALL;
+            armor.center = cv::Point2f(600.0f + 2.0f * i, 360.0f + 0.5f * i);
+            const cv::Point2f half(30.0f, 12.0f);
+            armor.vertices = {armor.center + cv::Point2f(-half.x, -half.y), armor.center + cv::Point2f(half.x, -half.y),
+                              armor.center + cv::Point2f(half.x, half.y), armor.center + cv::Point2f(-half.x, half.y)};
+            armor.boundingRect = cv::Rect(cvFloor(armor.center.x - half.x), cvFloor(armor.center.y - half.y),
+                                          cvCeil(half.x * 2.0f), cvCeil(half.y * 2.0f));
+
+            tracker.update(std::vector<Armor>{armor}, i * 0.01);
+            if (tracker.getState() == Tracker::TRACKING) {
+                if (confirmed_at < 0) confirmed_at = i;
+            } else if (confirmed_at > 0) {
+                dropped = true;
+            }
+        }
+
+        const char* name = filter_type == Tracker::IMM_FILTER ? "IMM" : "KF";
+        if (confirmed_at != threshold || dropped) {
+            std::cerr << "[ERROR] Tracker (" << name << ") steady target: TRACKING at frame " << confirmed_at
+                      << " (expected " << threshold << ")" << (dropped ? ", then dropped" : "") << std::endl;
+            ok = false;
+        } else {
+            std::cout << "[TRACKER] " << name << " steady target reaches TRACKING after " << confirmed_at
+                      << " frames" << std::endl;
+        }
+    }
+    return ok;
+}
+
+CaseResult runCase(const BenchCase& bench_case, int iterations) {
+    const int warmup = std::max(5, iterations / 10);
+
+    DetectorParams params;
+    params.log_frames = false;
+    params.roi.enable = false;   // 各阶段都在整幅图上计时
+
+    cv::Mat frame = makeFrame(bench_case, 12345u + bench_case.light_count * 31u + bench_case.clutter);
+
+    cv::Mat camera_matrix, dist_coeffs;
+    CameraCalibrator::generateDummyCameraParams(camera_matrix, dist_coeffs, frame.cols, frame.rows);
+
+    Detector detector(params);
+    PnPSolver pnp_solver;
+    pnp_solver.setCameraParams(camera_matrix, dist_coeffs);
+    CameraModel lens;
+    lens.set(camera_matrix, dist_coeffs);
+    volatile double undistort_sink = 0.0;
+    Tracker tracker;
+
+    std::vector<Light> lights;
+    std::vector<Armor> armors;
+    cv::Mat rvec, tvec;
+    PnPResult pose;
+    std::vector<PnPResult> poses;
+    // 热启动位姿跨迭代保留（静态帧，同一下标即同一装甲板）
+    std::vector<PnPResult> warm_poses, warm_last_poses;
+    // 闭式解与 OpenCV 结果的最大偏差
+    double max_pnp_dt = 0.0, max_pnp_dr = 0.0;
+
+    std::vector<double> t_preprocess, t_find, t_color, t_match, t_pnp, t_pnp_planar, t_pnp_batch, t_pnp_warm, t_undistort_corners, t_tracker, t_detect;
+    t_preprocess.reserve(iterations);
+    t_find.reserve(iterations);
+    t_color.reserve(iterations);
+    t_match.reserve(iterations);
+    t_pnp.reserve(iterations);
+    t_pnp_planar.reserve(iterations);
+    t_pnp_batch.reserve(iterations);
+    t_pnp_warm.reserve(iterations);
+    t_undistort_corners.reserve(iterations);
+    t_tracker.reserve(iterations);
+    t_detect.reserve(iterations);
+
+    for (int it = -warmup; it < iterations; ++it) {
+        const bool record = (it >= 0);
+
+        auto start = Clock::now();
+        cv::Mat binary = detector.preprocess(frame);
+        double preprocess_us = elapsedUs(start);
+
+        // determineColor 在 findLights 内部调用，耗时由 DebugInfo 累计
+        double color_before_ms = detector.getDebugInfo().color_time_ms;
+        start = Clock::now();
+        detector.findLights(frame, binary, lights);
+        double find_us = elapsedUs(start);
+        double color_us = (detector.getDebugInfo().color_time_ms - color_before_ms) * 1000.0;
+
+        start = Clock::now();
+        detector.matchLights(lights, armors);
+        double match_us = elapsedUs(start);
+
+        // PnP 按单次调用计时
+        double pnp_us = 0.0, pnp_planar_us = 0.0;
+        for (const auto& armor : armors) {
+            start = Clock::now();
+            const bool ok = pnp_solver.solvePnP(armor, rvec, tvec);
+            pnp_us += elapsedUs(start);
+
+            start = Clock::now();
+            pnp_solver.solvePlanar(armor, pose);
+            pnp_planar_us += elapsedUs(start);
+
+            if (ok && pose.valid) {
+                const cv::Vec3d r(rvec.at<double>(0), rvec.at<double>(1), rvec.at<double>(2));
+                const cv::Vec3d t(tvec.at<double>(0), tvec.at<double>(1), tvec.at<double>(2));
+                max_pnp_dt = std::max(max_pnp_dt, cv::norm(t - pose.tvec));
+                max_pnp_dr = std::max(max_pnp_dr, cv::norm(r - pose.rvec));
+            }
+        }
+
+        start = Clock::now();
+        pnp_solver.solveBatch(armors, poses);
+        double pnp_batch_us = elapsedUs(start);
+
+        warm_poses.resize(armors.size());
+        warm_last_poses.resize(armors.size());
+        start = Clock::now();
+        for (size_t i = 0; i < armors.size(); ++i) {
+            pnp_solver.solveTracked(armors[i], warm_poses[i], warm_last_poses[i]);
+        }
+        double pnp_warm_us = elapsedUs(start);
+
+        // 只对角点去畸变（solvePlanar / solveTracked 内部的做法，代替整幅图像去畸变）
+        start = Clock::now();
+        for (const auto& armor : armors) {
+            for (const auto& vertex : armor.vertices) {
+                undistort_sink = undistort_sink + lens.undistortNormalized(vertex).x;
+            }
+        }
+        double undistort_corners_us = elapsedUs(start);
+
+        start = Clock::now();
+        tracker.update(armors);
+        double tracker_us = elapsedUs(start);
+
+        start = Clock::now();
+        detector.detect(frame);
+        double detect_us = elapsedUs(start);
+
+        if (record) {
+            t_preprocess.push_back(preprocess_us);
+            t_find.push_back(find_us);
+            t_color.push_back(color_us);
+            t_match.push_back(match_us);
+            if (!armors.empty()) {
+                t_pnp.push_back(pnp_us / armors.size());
+                t_pnp_planar.push_back(pnp_planar_us / armors.size());
+                t_pnp_batch.push_back(pnp_batch_us / armors.size());
+                t_pnp_warm.push_back(pnp_warm_us / armors.size());
+                t_undistort_corners.push_back(undistort_corners_us / armors.size());
+            }
+            t_tracker.push_back(tracker_us);
+            t_detect.push_back(detect_us);
+        }
+    }
+
+    // 去畸变：每次重建映射表的 cv::undistort 对比缓存映射表的 remap，以及只处理搜索窗口大小的区域
+    std::vector<double> t_undistort, t_undistort_remap, t_undistort_roi;
+    t_undistort.reserve(iterations);
+    t_undistort_remap.reserve(iterations);
+    t_undistort_roi.reserve(iterations);
+    CameraCalibrator calibrator;
+    calibrator.setCameraParams(camera_matrix, dist_coeffs);
+    calibrator.initUndistortMaps(frame.size());
+    const cv::Rect undistort_roi(frame.cols / 4, frame.rows / 4, frame.cols / 2, frame.rows / 2);
+    cv::Mat undistorted;
+    for (int it = -warmup; it < iterations; ++it) {
+        auto start = Clock::now();
+        cv::undistort(frame, undistorted, camera_matrix, dist_coeffs);
+        double undistort_us = elapsedUs(start);
+
+        start = Clock::now();
+        calibrator.undistortImage(frame, undistorted);
+        double remap_us = elapsedUs(start);
+
+        start = Clock::now();
+        calibrator.undistortImage(frame, undistorted, undistort_roi);
+        double roi_us = elapsedUs(start);
+
+        if (it >= 0) {
+            t_undistort.push_back(undistort_us);
+            t_undistort_remap.push_back(remap_us);
+            t_undistort_roi.push_back(roi_us);
+        }
+    }
+
+    // 批量投影/反投影：一次 512 个点，相当于叠加显示每帧投影的点数
+    constexpr int projection_points = 512;
+    std::vector<double> t_project, t_backproject;
+    t_project.reserve(iterations);
+    t_backproject.reserve(iterations);
+    CoordinateTransformer transformer;
+    transformer.setCameraParams(camera_matrix, dist_coeffs);
+    std::vector<cv::Point3f> world_points(projection_points), rays;
+    std::vector<cv::Point2f> pixels;
+    for (int i = 0; i < projection_points; ++i) {
+        world_points[i] = cv::Point3f((i % 32) * 0.05f - 0.8f, (i / 32) * 0.05f - 0.4f, 2.0f + (i % 7) * 0.5f);
+    }
+    for (int it = -warmup; it < iterations; ++it) {
+        auto start = Clock::now();
+        transformer.worldToPixel(world_points, pixels);
+        double project_us = elapsedUs(start);
+
+        start = Clock::now();
+        transformer.pixelToWorld(pixels, rays, 1.0f, true);
+        double backproject_us = elapsedUs(start);
+
+        if (it >= 0) {
+            t_project.push_back(project_us);
+            t_backproject.push_back(backproject_us);
+        }
+    }
+
+    // 云台姿态：缓冲中 2 秒的 1 kHz 采样，每帧按时间戳二分 + slerp，再组合相机到世界系的变换
+    std::vector<double> t_imu_lookup;
+    t_imu_lookup.reserve(iterations);
+    ImuPoseBuffer imu_buffer;
+    for (int i = 0; i < 2000; ++i) {
+        const double t = i * 0.001;
+        imu_buffer.push(t, Quaternion::fromEuler(std::sin(2.0 * t), 0.2 * std::sin(5.0 * t), 0.0));
+    }
+    const CameraMount camera_mount;
+    RigidTransform camera_to_world;
+    for (int it = -warmup; it < iterations; ++it) {
+        const double t = 0.5 + ((it + warmup) % 100) * 0.0137;
+        auto start = Clock::now();
+        imu_buffer.cameraToWorld(t, camera_mount, camera_to_world);
+        double imu_us = elapsedUs(start);
+
+        if (it >= 0) {
+            t_imu_lookup.push_back(imu_us);
+        }
+    }
+
+    // 卡尔曼滤波：单次 predict/update，目标匀速运动
+    std::vector<double> t_kf_predict, t_kf_update;
+    t_kf_predict.reserve(iterations);
+    t_kf_update.reserve(iterations);
+    KalmanFilter kf;
+    kf.init(cv::Point2f(frame.cols * 0.5f, frame.rows * 0.5f));
+    for (int it = -warmup; it < iterations; ++it) {
+        cv::Point2f measurement(frame.cols * 0.5f + it * 0.7f, frame.rows * 0.5f + it * 0.3f);
+
+        auto start = Clock::now();
+        kf.predict();
+        double predict_us = elapsedUs(start);
+
+        start = Clock::now();
+        kf.update(measurement);
+        double update_us = elapsedUs(start);
+
+        if (it >= 0) {
+            t_kf_predict.push_back(predict_us);
+            t_kf_update.push_back(update_us);
+        }
+    }
+
+    // IMM（匀速/匀加速/静止）：每帧一次 predict + update
+    std::vector<double> t_imm;
+    t_imm.reserve(iterations);
+    ImmKalmanFilter imm;
+    imm.init(cv::Point2f(frame.cols * 0.5f, frame.rows * 0.5f), 0.0);
+    for (int it = -warmup; it < iterations; ++it) {
+        const double t = (it + warmup + 1) * 0.033;
+        cv::Point2f measurement(frame.cols * 0.5f + it * 0.7f, frame.rows * 0.5f + it * 0.3f);
+
+        auto start = Clock::now();
+        imm.predict(t);
+        imm.update(measurement);
+        double imm_us = elapsedUs(start);
+
+        if (it >= 0) {
+            t_imm.push_back(imm_us);
+        }
+    }
+
+    // 批量卡尔曼滤波：32 个目标一次 predict + update，约 2/3 的目标有测量值
+    const int batch_tracks = 32;
+    std::vector<double> t_kf_batch;
+    t_kf_batch.reserve(iterations);
+    BatchedKalmanFilter batch_kf(batch_tracks);
+    for (int i = 0; i < batch_tracks; ++i) {
+        batch_kf.add(cv::Point2f(i * 40.0f, frame.rows * 0.5f));
+    }
+    for (int it = -warmup; it < iterations; ++it) {
+        auto start = Clock::now();
+        batch_kf.predict(0.033f);
+        for (int i = 0; i < batch_tracks; ++i) {
+            if ((i + it) % 3 != 0) {
+                batch_kf.setMeasurement(i, cv::Point2f(i * 40.0f + it * 0.7f, frame.rows * 0.5f + it * 0.3f));
+            }
+        }
+        batch_kf.update();
+        double batch_us = elapsedUs(start);
+
+        if (it >= 0) {
+            t_kf_batch.push_back(batch_us);
+        }
+    }
+
+    // 整车 EKF：自旋目标，每帧 predict + 两块可见装甲板的校正
+    std::vector<double> t_robot_ekf;
+    t_robot_ekf.reserve(iterations);
+    RobotEkf robot_ekf;
+    for (int it = -warmup; it < iterations; ++it) {
+        const double t = (it + warmup) * 0.01;
+        const float yaw = static_cast<float>(6.0 * t);
+        ArmorObservation armors[2];
+        for (int k = 0; k < 2; ++k) {
+            const float a = yaw + k * 1.5707963f;
+            armors[k].position = cv::Point3f(3.0f + 0.25f * std::cos(a), 0.25f * std::sin(a), 0.1f);
+            armors[k].yaw = RobotEkf::unwrapAngle(a, 0.0f);
+        }
+        if (!robot_ekf.isInitialized()) {
+            robot_ekf.init(armors[0], t);
+            continue;
+        }
+
+        auto start = Clock::now();
+        robot_ekf.predict(t);
+        robot_ekf.update(armors[0]);
+        robot_ekf.update(armors[1]);
+        double ekf_us = elapsedUs(start);
+
+        if (it >= 0) {
+            t_robot_ekf.push_back(ekf_us);
+        }
+    }
+
+    // 弹道解算：查表单次耗时远小于计时开销，按 64 次查询一组计时后取平均
+    const BallisticSolver& ballistic = ballisticSolver();
+    constexpr int ballistic_batch = 64;
+    std::vector<double> t_ballistic, t_ballistic_ref;
+    t_ballistic.reserve(iterations);
+    volatile float ballistic_sink = 0.0f;
+    for (int it = -warmup; it < iterations; ++it) {
+        auto start = Clock::now();
+        for (int q = 0; q < ballistic_batch; ++q) {
+            const int i = (it + warmup) * ballistic_batch + q;
+            const cv::Point3f target(2.0f + (i % 97) * 0.15f, (i % 13) * 0.1f - 0.6f, (i % 23) * 0.1f - 1.0f);
+            ballistic_sink = ballistic_sink + ballistic.solve(target, 25.0).pitch;
+        }
+        double ballistic_us = elapsedUs(start) / ballistic_batch;
+
+        if (it >= 0) {
+            t_ballistic.push_back(ballistic_us);
+        }
+    }
+    // 参考积分器单次为毫秒级，只取少量样本
+    for (int it = 0; it < std::min(iterations, 10); ++it) {
+        auto start = Clock::now();
+        ballistic_sink = ballistic_sink +
+            BallisticSolver::solveReference(ballistic.getParams(), 4.0 + it, 0.3, 25.0).pitch;
+        t_ballistic_ref.push_back(elapsedUs(start));
+    }
+
+    if (!armors.empty()) {
+        std::cout << "[PNP] planar vs OpenCV IPPE: max |dt| " << std::scientific << std::setprecision(2)
+                  << max_pnp_dt << " m, max |drvec| " << max_pnp_dr << " rad" << std::defaultfloat << std::endl;
+    }
+
+    CaseResult result;
+    result.bench_case = bench_case;
+    result.armors_found = static_cast<int>(armors.size());
+    result.stages.push_back(summarize("preprocess", t_preprocess));
+    result.stages.push_back(summarize("findLights", t_find));
+    result.stages.push_back(summarize("determineColor", t_color));
+    result.stages.push_back(summarize("matchLights", t_match));
+    result.stages.push_back(summarize("solvePnP", t_pnp));
+    result.stages.push_back(summarize("pnp_planar", t_pnp_planar));
+    result.stages.push_back(summarize("pnp_batch", t_pnp_batch));
+    result.stages.push_back(summarize("pnp_warm", t_pnp_warm));
+    result.stages.push_back(summarize("undistort", t_undistort));
+    result.stages.push_back(summarize("undistort_corners", t_undistort_corners));
+    result.stages.push_back(summarize("undistort_remap", t_undistort_remap));
+    result.stages.push_back(summarize("undistort_roi", t_undistort_roi));
+    result.stages.push_back(summarize("project_512", t_project));
+    result.stages.push_back(summarize("backproject_512", t_backproject));
+    result.stages.push_back(summarize("imu_lookup", t_imu_lookup));
+    result.stages.push_back(summarize("kf_predict", t_kf_predict));
+    result.stages.push_back(summarize("kf_update", t_kf_update));
+    result.stages.push_back(summarize("imm_step", t_imm));
+    result.stages.push_back(summarize("kf_batch32", t_kf_batch));
+    result.stages.push_back(summarize("robot_ekf", t_robot_ekf));
+    result.stages.push_back(summarize("ballistic", t_ballistic));
+    result.stages.push_back(summarize("ballistic_ref", t_ballistic_ref));
+    result.stages.push_back(summarize("tracker_update", t_tracker));
+    result.stages.push_back(summarize("detect_total", t_detect));
+    return result;
+}
+
+// 读取基线 JSON 中各用例各阶段的中位数与标准差（用例名/阶段名 -> 结果）
+std::map<std::string, StageResult> loadBaseline(const std::string& path) {
+    std::map<std::string, StageResult> baseline;
+    cv::FileStorage fs(path, cv::FileStorage::READ);
+    if (!fs.isOpened()) {
+        std::cerr << "[ERROR] Cannot open baseline: " << path << std::endl;
+        return baseline;
+    }
+
+    cv::FileNode cases = fs["cases"];
+    for (cv::FileNodeIterator it = cases.begin(); it != cases.end(); ++it) {
+        cv::FileNode node = *it;
+        std::string name = (std::string)node["name"];
+        cv::FileNode stages = node["stages"];
+        for (cv::FileNodeIterator st = stages.begin(); st != stages.end(); ++st) {
+            cv::FileNode stage = *st;
+            StageResult& base = baseline[name + "/" + stage.name()];
+            base.stage = stage.name();
+            base.median_us = (double)stage["median_us"];
+            base.stddev_us = (double)stage["stddev_us"];
+        }
+    }
+    return baseline;
+}
+
+bool writeJson(const std::string& path, const std::vector<CaseResult>& results, int iterations) {
+    cv::FileStorage fs(path, cv::FileStorage::WRITE | cv::FileStorage::FORMAT_JSON);
+    if (!fs.isOpened()) {
+        std::cerr << "[ERROR] Cannot create result file: " << path << std::endl;
+        return false;
+    }
+
+    fs << "benchmark" << "armor_detector_stages";
+    fs << "iterations" << iterations;
+    fs << "cases" << "[";
+    for (const auto& result : results) {
+        fs << "{";
+        fs << "name" << result.bench_case.name();
+        fs << "width" << result.bench_case.resolution.width;
+        fs << "height" << result.bench_case.resolution.height;
+        fs << "lights" << result.bench_case.light_count;
+        fs << "clutter" << result.bench_case.clutter;
+        fs << "armors_found" << result.armors_found;
+        fs << "stages" << "{";
+        for (const auto& stage : result.stages) {
+            fs << stage.stage << "{";
+            fs << "samples" << static_cast<int>(stage.samples);
+            fs << "mean_us" << stage.mean_us;
+            fs << "median_us" << stage.median_us;
+            fs << "p99_us" << stage.p99_us;
+            fs << "min_us" << stage.min_us;
+            fs << "stddev_us" << stage.stddev_us;
+            fs << "}";
+        }
+        fs << "}";
+        fs << "}";
+    }
+    fs << "]";
+    fs.release();
+
+    std::cout << "[INFO] Results saved to: " << path << std::endl;
+    return true;
+}
+
+void printCase(const CaseResult& result, const std::map<std::string, StageResult>& baseline) {
+    std::cout << "\n== " << result.bench_case.name() << " (" << result.armors_found
+              << " armors) ==" << std::endl;
+    std::cout << std::left << std::setw(16) << "stage"
+              << std::right << std::setw(11) << "median_us"
+              << std::setw(11) << "mean_us"
+              << std::setw(11) << "p99_us"
+              << std::setw(11) << "stddev_us";
+    if (!baseline.empty()) {
+        std::cout << std::setw(12) << "vs_base" << std::setw(12) << "sd_vs_base";
+    }
+    std::cout << std::endl;
+
+    for (const auto& stage : result.stages) {
+        std::cout << std::left << std::setw(16) << stage.stage << std::right
+                  << std::fixed << std::setprecision(2)
+                  << std::setw(11) << stage.median_us
+                  << std::setw(11) << stage.mean_us
+                  << std::setw(11) << stage.p99_us
+                  << std::setw(11) << stage.stddev_us;
+        auto it = baseline.find(result.bench_case.name() + "/" + stage.stage);
+        if (it != baseline.end() && stage.median_us > 0.0) {
+            // >1 表示比基线快 / 抖动比基线小
+            std::cout << std::setw(11) << it->second.median_us / stage.median_us << "x";
+            if (stage.stddev_us > 0.0) {
+                std::cout << std::setw(11) << it->second.stddev_us / stage.stddev_us << "x";
+            }
+        }
+        std::cout << std::endl;
+    }
+}
+
+std::vector<std::string> split(const std::string& text, char sep) {
+    std::vector<std::string> parts;
+    std::stringstream ss(text);
+    std::string part;
+    while (std::getline(ss, part, sep)) {
+        if (!part.empty()) parts.push_back(part);
+    }
+    return parts;
+}
+
+void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  --resolutions WxH,...  frame sizes (default 640x480,1280x720,1920x1080,3840x2160)\n"
+              << "  --lights N,...         target-colour lights per frame (default 8)\n"
+              << "  --clutter N,...        clutter levels, 0 = clean (default 0,2)\n"
+              << "  --iterations N         timed iterations per case (default 200)\n"
+              << "  --json FILE            write results as JSON\n"
+              << "  --baseline FILE        compare medians and stddev against a previous JSON result\n"
+              << "  --checks-only          run the consistency/allocation checks and exit\n"
+              << "  --require-alloc-count  fail if allocation counting is not compiled in" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::vector<cv::Size> resolutions = {
+        cv::Size(640, 480), cv::Size(1280, 720), cv::Size(1920, 1080), cv::Size(3840, 2160)
+    };
+    std::vector<int> light_counts = {8};
+    std::vector<int> clutter_levels = {0, 2};
+    int iterations = 200;
+    std::string json_path;
+    std::string baseline_path;
+    bool checks_only = false;
+    bool require_alloc_count = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = (i + 1 < argc);
+        if (arg == "--resolutions" && has_value) {
+            resolutions.clear();
+            for (const auto& item : split(argv[++i], ',')) {
+                int w = 0, h = 0;
+                if (std::sscanf(item.c_str(), "%dx%d", &w, &h) == 2 && w > 0 && h > 0) {
+                    resolutions.emplace_back(w, h);
+                }
+            }
+        } else if (arg == "--lights" && has_value) {
+            light_counts.clear();
+            for (const auto& item : split(argv[++i], ',')) light_counts.push_back(std::stoi(item));
+        } else if (arg == "--clutter" && has_value) {
+            clutter_levels.clear();
+            for (const auto& item : split(argv[++i], ',')) clutter_levels.push_back(std::stoi(item));
+        } else if (arg == "--iterations" && has_value) {
+            iterations = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--json" && has_value) {
+            json_path = argv[++i];
+        } else if (arg == "--baseline" && has_value) {
+            baseline_path = argv[++i];
+        } else if (arg == "--checks-only") {
+            checks_only = true;
+        } else if (arg == "--require-alloc-count") {
+            require_alloc_count = true;
+        } else {
+            printUsage(argv[0]);
+            return arg == "--help" || arg == "-h" ? 0 : -1;
+        }
+    }
+
+    std::map<std::string, StageResult> baseline;
+    if (!baseline_path.empty()) {
+        baseline = loadBaseline(baseline_path);
+    }
+
+    checkBallisticAccuracy(100);
+    if (!checkBatchedKalmanConsistency() || !checkTrackerConfirmation() ||
+        !checkSteadyStateAllocations(require_alloc_count)) {
+        return -1;
+    }
+    if (checks_only) {
+        return 0;
+    }
+
+    std::vector<CaseResult> results;
+    for (const auto& resolution : resolutions) {
+        for (int lights : light_counts) {
+            for (int clutter : clutter_levels) {
+                BenchCase bench_case;
+                bench_case.resolution = resolution;
+                bench_case.light_count = lights;
+                bench_case.clutter = clutter;
+
+                results.push_back(runCase(bench_case, iterations));
+                printCase(results.back(), baseline);
+            }
+        }
+    }
+
+    if (!json_path.empty() && !writeJson(json_path, results, iterations)) {
+        return -1;
+    }
+    return 0;
+}
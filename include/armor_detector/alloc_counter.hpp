@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+
+namespace rm_auto_aim {
+namespace alloc_counter {
+
+// 堆分配计数钩子（测试用）：以 RM_COUNT_ALLOCATIONS 编译时替换 glibc 的 malloc 系列函数，
+// 统计分配次数（含 operator new 与 OpenCV 内部分配）。
+// 未启用时 enabled() 为 false，计数恒为 0。
+bool enabled();
+// 调用线程的分配次数：流水线中检测线程的统计不混入采集、跟踪线程的分配
+std::size_t count();
+// 所有线程的分配次数
+std::size_t totalCount();
+
+} // namespace alloc_counter
+} // namespace rm_auto_aim
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <array>
+#include <opencv2/opencv.hpp>
+
+namespace rm_auto_aim {
+
+// 颜色定义
+const int RED = 0;
+const int BLUE = 1;
+
+enum class ArmorType { SMALL, LARGE, INVALID };
+
+// 灯条
+struct Light {
+    cv::RotatedRect rect;
+    cv::Point2f center;
+    cv::Point2f top;
+    cv::Point2f bottom;
+    float width = 0.0f;
+    float length = 0.0f;
+    float angle = 0.0f;
+    int color = RED;
+    
+    cv::Rect boundingRect() const { return rect.boundingRect(); }
+};
+
+// 装甲板（值类型，可直接复制、跨帧/跨线程保存）
+struct Armor {
+    Armor() = default;
+    // left_index / right_index 为两根灯条在所属灯条数组中的下标
+    Armor(const Light& left_light, const Light& right_light,
+          int left_index = -1, int right_index = -1);
+    
+    void updateVertices(const Light& left_light, const Light& right_light);
+    void draw(cv::Mat& img, const cv::Scalar& color, int thickness = 2) const;
+    
+    bool isValid() const {
+        return type != ArmorType::INVALID;
+    }
+    
+    // 灯条下标，引用 Detector::getTargetLights() 或 DetectionFrame::lights
+    int left_light = -1;
+    int right_light = -1;
+    
+    cv::Point2f center;
+    // 顶点顺序：左上 -> 右上 -> 右下 -> 左下
+    std::array<cv::Point2f, 4> vertices;
+    cv::Rect boundingRect;
+    ArmorType type = ArmorType::INVALID;
+};
+
+} // namespace rm_auto_aim
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <vector>
+
+namespace rm_auto_aim {
+
+// 矩形代价矩阵的最小代价分配（匈牙利算法，势函数 + 最短增广路，O(n^2 m)）。
+// 工作区跨调用复用，规模不超过历史最大值时不分配内存
+class AssignmentSolver {
+public:
+    // cost 为 rows x cols 的行优先矩阵；row_to_col[i] 为第 i 行分到的列，未分配为 -1。
+    // 行数多于列数时按转置求解，保证每一列（或每一行）恰好分到一个。返回总代价
+    double solve(const float* cost, int rows, int cols, std::vector<int>& row_to_col);
+
+private:
+    double solveWide(const float* cost, int rows, int cols, bool transposed,
+                     std::vector<int>& row_to_col);
+
+    std::vector<double> u_, v_, minv_;
+    std::vector<int> p_, way_;
+    std::vector<char> used_;
+};
+
+} // namespace rm_auto_aim
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+namespace rm_auto_aim
+{
+// 弹道模型与查找表范围（单位：米、秒、弧度）
+struct BallisticParams
+{
+  double gravity = 9.8;
+  // 二次空气阻力 a = -k |v| v，k = rho * Cd * A / (2m)（1/m）。
+  // 17mm 弹丸约 0.019，42mm 弹丸约 0.0095
+  double drag_coeff = 0.019;
+
+  // 查找表网格：水平距离、高度差、初速、俯仰角
+  double min_distance = 0.5;
+  double max_distance = 25.5;
+  double distance_step = 0.25;
+  double min_height = -3.0;
+  double max_height = 3.0;
+  double height_step = 0.1;
+  double min_speed = 10.0;
+  double max_speed = 32.0;
+  double speed_step = 0.5;
+  double min_pitch = -0.6;
+  double max_pitch = 0.8;
+  double pitch_step = 0.01;
+
+  double max_flight_time = 3.0;
+  double integration_step = 2e-3;  // 建表时 RK4 的积分步长
+};
+
+struct BallisticSolution
+{
+  bool valid = false;
+  float pitch = 0.0f;        // 弧度，向上为正
+  float yaw = 0.0f;          // 弧度，向左为正
+  float flight_time = 0.0f;  // 秒
+};
+
+// 带空气阻力的弹道解算：由目标点与初速求云台 pitch/yaw 与飞行时间。
+//
+// 构造时用 RK4 对每个（初速, 俯仰角）积分一次，沿途记录经过各距离网格时的高度与时间，
+// 得到正向表 (speed, pitch, distance) -> (height, time)；再沿 pitch 方向对其求逆，
+// 得到反向表 (speed, distance, height) -> pitch（只取上升段对应的低弹道解）。
+// 查询时先在反向表中三线性插值得到初值，再在正向表上做一步牛顿迭代消除插值误差，
+// 不积分、不分配内存。
+class BallisticSolver
+{
+public:
+  explicit BallisticSolver(const BallisticParams& params = BallisticParams());
+
+  // 平面内求解：水平距离、相对枪口的高度差（米），初速（m/s）。yaw 恒为 0
+  BallisticSolution solve(double distance, double height, double speed) const;
+  // 世界系目标点（x 前 / y 左 / z 上，原点为枪口）
+  BallisticSolution solve(const cv::Point3f& target, double speed) const;
+
+  const BallisticParams& getParams() const { return params_; }
+  // 正向表与反向表占用的内存（字节）
+  std::size_t tableBytes() const { return forward_.size() * sizeof(Sample) + inverse_.size() * sizeof(float); }
+
+  // 以 pitch 发射、飞到水平距离 distance 时的高度与时间（RK4 积分），到不了返回 false
+  static bool simulate(const BallisticParams& params, double speed, double pitch, double distance,
+                       double& height, double& time, double dt = 1e-4);
+  // 参考解：逐步积分 + 二分求 pitch，单次约毫秒级，仅用于校验与基准
+  static BallisticSolution solveReference(const BallisticParams& params, double distance, double height,
+                                          double speed, double dt = 1e-4);
+
+private:
+  struct Sample
+  {
+    float height;
+    float time;
+  };
+
+  void buildForwardTable();
+  void buildInverseTable();
+  // 正向表在 (speed, pitch, distance) 处的高度、高度对 pitch 的导数与时间
+  bool lookupForward(double speed, double pitch, double distance,
+                     float& height, float& dheight, float& time) const;
+
+  const Sample& forward(int speed, int pitch, int distance) const
+  {
+    return forward_[(static_cast<std::size_t>(speed) * pitchCount_ + pitch) * distanceCount_ + distance];
+  }
+  float inverse(int speed, int distance, int height) const
+  {
+    return inverse_[(static_cast<std::size_t>(speed) * distanceCount_ + distance) * heightCount_ + height];
+  }
+
+  BallisticParams params_;
+  int speedCount_ = 0;
+  int pitchCount_ = 0;
+  int distanceCount_ = 0;
+  int heightCount_ = 0;
+  std::vector<Sample> forward_;  // [speed][pitch][distance]，到不了的距离为 NaN
+  std::vector<float> inverse_;   // [speed][distance][height] -> pitch，无解为 NaN
+};
+
+}  // namespace rm_auto_aim
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+namespace rm_auto_aim
+{
+// 多目标匀速模型卡尔曼滤波，按结构体数组（SoA）存放所有目标的状态。
+//
+// 与 KalmanFilter 使用同一模型（状态 x, vx, y, vy，只测量位置，Q、R、P0 为对角阵）。
+// 该模型下 x、y 两轴互不耦合，4x4 协方差中只有每轴的 2x2 块非零，
+// 因此每个目标每轴只需保存 位置、速度 和 P00、P01、P11 三个协方差元素。
+// 所有目标的同一分量连续存放，predict / update 一次处理全部目标：
+// x86 上运行时检测 AVX2（每次 8 个目标），ARM 上使用 NEON（每次 4 个），其余走标量实现。
+// 各实现的运算顺序相同，且本文件以 -ffp-contract=off 编译（编译器不把乘加合成 FMA），
+// 结果逐位一致；基准程序中的 checkBatchedKalmanConsistency 对照标量实现校验。
+class BatchedKalmanFilter
+{
+public:
+  // use_simd 为 false 时始终走标量实现（用于对照校验）
+  explicit BatchedKalmanFilter(std::size_t capacity = 64, bool use_simd = true);
+
+  // 新增一个目标，返回其下标
+  int add(const cv::Point2f& initial_pos);
+  // 删除下标 i 的目标：最后一个目标移动到 i（调用方需同步调整自己的下标）
+  void remove(int i);
+  void clear();
+
+  // 全部目标前进 dt 秒
+  void predict(float dt);
+  // 登记下标 i 的目标本帧的测量值，由下一次 update() 统一校正
+  void setMeasurement(int i, const cv::Point2f& measurement);
+  // 用已登记的测量值校正对应目标，未登记的目标保持预测值；之后清空登记
+  void update();
+
+  cv::Point2f position(int i) const { return cv::Point2f(x_.pos[i], y_.pos[i]); }
+  cv::Point2f velocity(int i) const { return cv::Point2f(x_.vel[i], y_.vel[i]); }
+  // 匀速外推 dt 秒后的位置，不改变状态
+  cv::Point2f positionAfter(int i, float dt) const
+  {
+    return cv::Point2f(x_.pos[i] + x_.vel[i] * dt, y_.pos[i] + y_.vel[i] * dt);
+  }
+
+  // 位置观测的新息方差 S = P00 + R（两轴互不耦合，S 为对角阵）
+  cv::Point2f innovationVariance(int i) const { return cv::Point2f(x_.p00[i] + r_, y_.p00[i] + r_); }
+
+  std::size_t size() const { return x_.pos.size(); }
+
+private:
+  // 单轴状态
+  struct Axis
+  {
+    std::vector<float> pos;
+    std::vector<float> vel;
+    std::vector<float> p00;   // 位置方差
+    std::vector<float> p01;   // 位置-速度协方差
+    std::vector<float> p11;   // 速度方差
+    std::vector<float> z;     // 本帧测量值
+  };
+
+  static void reserveAxis(Axis& axis, std::size_t capacity);
+  static void addAxis(Axis& axis, float pos, float p0);
+  static void removeAxis(Axis& axis, int i);
+  void predictAxis(Axis& axis, float dt, float q_pos, float q_vel);
+  void updateAxis(Axis& axis);
+
+  Axis x_;
+  Axis y_;
+  bool use_simd_ = true;
+  // 非零表示该目标本帧有测量值
+  std::vector<unsigned char> has_measurement_;
+  bool any_measurement_ = false;
+
+  // 与 KalmanFilter 相同的噪声参数（Q 随 dt 线性缩放）
+  static constexpr float nominalDt_ = 0.033f;
+  static constexpr float qPos_ = 0.1f;
+  static constexpr float qVel_ = 0.5f;
+  static constexpr float r_ = 5.0f;
+  static constexpr float p0_ = 0.1f;
+};
+
+}  // namespace rm_auto_aim
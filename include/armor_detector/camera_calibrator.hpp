@@ -0,0 +1,62 @@
+#pragma once
+
+#include <mutex>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+namespace rm_auto_aim {
+
+class CameraCalibrator {
+public:
+    CameraCalibrator();
+    
+    // 从棋盘格图像目录标定相机，结果保存到 save_path
+    bool calibrateFromChessboard(const std::string& image_dir,
+                                 cv::Size pattern_size,
+                                 double square_size,
+                                 const std::string& save_path);
+    
+    bool loadCalibration(const std::string& file_path);
+    bool saveCalibration(const std::string& file_path) const;
+    
+    void setCameraParams(const cv::Mat& camera_matrix, const cv::Mat& dist_coeffs);
+    // 去畸变：按分辨率缓存 initUndistortRectifyMap 的映射表（CV_16SC2 定点格式），之后每帧只做 remap。
+    // 相机参数变化或分辨率变化时重建映射表
+    void undistortImage(const cv::Mat& src, cv::Mat& dst) const;
+    // 只去畸变输出图像中的 roi 区域（如跟踪器的搜索窗口），dst 大小为 roi.size()，
+    // dst(y, x) 对应整幅去畸变图像的 (roi.y + y, roi.x + x)
+    void undistortImage(const cv::Mat& src, cv::Mat& dst, const cv::Rect& roi) const;
+    // 预先生成该分辨率的映射表，避免第一帧去畸变时的建表耗时
+    bool initUndistortMaps(const cv::Size& image_size) const;
+    
+    cv::Mat getCameraMatrix() const { return camera_matrix_; }
+    cv::Mat getDistCoeffs() const { return dist_coeffs_; }
+    double getCalibrationError() const { return calibration_error_; }
+    
+    // 生成虚拟相机参数（用于测试）
+    static void generateDummyCameraParams(cv::Mat& camera_matrix, cv::Mat& dist_coeffs,
+                                          int image_width, int image_height);
+    
+private:
+    bool findChessboardCorners(const std::vector<std::string>& image_paths,
+                               cv::Size pattern_size,
+                               std::vector<std::vector<cv::Point2f>>& image_points,
+                               std::vector<std::vector<cv::Point3f>>& object_points,
+                               double square_size);
+    // 取得 image_size 对应的映射表（不存在时生成），返回的 Mat 头与缓存共享数据
+    bool getUndistortMaps(const cv::Size& image_size, cv::Mat& map1, cv::Mat& map2) const;
+    void clearUndistortMaps();
+    
+    cv::Mat camera_matrix_;
+    cv::Mat dist_coeffs_;
+    double calibration_error_;
+    
+    // 去畸变映射表缓存；重建时换成新的 Mat，正在使用旧表的 remap 不受影响
+    mutable std::mutex map_mutex_;
+    mutable cv::Mat map1_;
+    mutable cv::Mat map2_;
+    mutable cv::Size map_size_;
+};
+
+} // namespace rm_auto_aim
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+
+namespace rm_auto_aim {
+
+// 针孔相机 + OpenCV 畸变模型（k1, k2, p1, p2, k3, k4, k5, k6）的逐点计算。
+// 只对检测到的角点、灯条端点做去畸变，不需要整幅图像 undistort / remap
+struct CameraModel {
+    double fx = 0.0, fy = 0.0, cx = 0.0, cy = 0.0;
+    double dist[8] = {};
+    bool has_distortion = false;
+    
+    // camera_matrix 为空时模型无效；dist_coeffs 可为空（无畸变），多于 8 个的系数忽略
+    void set(const cv::Mat& camera_matrix, const cv::Mat& dist_coeffs);
+    bool isValid() const { return fx > 0.0 && fy > 0.0; }
+    
+    // 像素坐标 -> 去畸变后的归一化坐标（与 cv::undistortPoints 相同的 5 次不动点迭代）
+    cv::Point2d undistortNormalized(const cv::Point2f& pixel) const;
+    // 归一化坐标 -> 像素坐标（含畸变）
+    cv::Point2d projectNormalized(double x, double y) const;
+};
+
+} // namespace rm_auto_aim
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+
+namespace rm_auto_aim {
+
+// HSV阈值区间（闭区间，语义与 cv::inRange 相同，H 取值 0~180）
+struct HsvRange {
+    int h_min = 0, h_max = 0;
+    int s_min = 0, s_max = 0;
+    int v_min = 0, v_max = 0;
+};
+
+// 按 cv::inRange 的规则把浮点/整数阈值规整为 8 位区间（四舍五入、截断，空区间记为 [1, 0]）
+HsvRange makeHsvRange(double h_min, double h_max,
+                      double s_min, double s_max,
+                      double v_min, double v_max);
+
+// 融合颜色掩码：单次读取 BGR 图像直接写出二值掩码，不生成中间 HSV 图。
+// 输出与 cvtColor(BGR2HSV) + inRange (+ bitwise_or) 逐位一致；
+// range_count 为 1（蓝色）或 2（红色的两个色相区间）。
+// x86 上运行时检测 AVX2，ARM 上使用 NEON，其余平台走标量实现。
+void fusedColorMask(const cv::Mat& bgr, cv::Mat& mask,
+                    const HsvRange* ranges, int range_count);
+
+// 3x3 矩形核先闭运算再开运算（原地），与两次 cv::morphologyEx(MORPH_CLOSE / MORPH_OPEN)
+// 在默认边界下结果一致；tmp 为与 mask 同尺寸的 CV_8UC1 工作区，函数内部不分配内存
+void morphCloseOpen3x3(cv::Mat& mask, cv::Mat& tmp);
+
+// 灯条颜色投票结果：旋转矩形内（含边界）像素的 B、R 通道和
+struct ColorVote {
+    long long sum_b = 0;
+    long long sum_r = 0;
+    int pixel_count = 0;
+};
+
+// 统计四边形 vertices 内的像素，只遍历 roi（已裁剪到图像内）中的像素。
+// 像素取舍与逐像素 cv::pointPolygonTest(contour, pt, false) >= 0 完全一致：
+// 按扫描线求出每行的内部区间，区间中部整段累加，只对两端附近的像素做精确判定。
+// mask 非空时只统计掩码非零的像素（例如 preprocess 得到的二值图）。
+ColorVote voteLightColor(const cv::Mat& bgr, const cv::Point2f vertices[4],
+                         const cv::Rect& roi, const cv::Mat& mask = cv::Mat());
+
+} // namespace rm_auto_aim
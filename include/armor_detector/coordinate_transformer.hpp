@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <opencv2/opencv.hpp>
+#include <vector>
+#include "armor_detector/camera_model.hpp"
+
+namespace rm_auto_aim
+{
+// 前向声明，避免循环依赖
+class CameraCalibrator;
+
+class CoordinateTransformer
+{
+public:
+  CoordinateTransformer();
+  
+  void setCameraMatrix(const cv::Mat& matrix);
+  void setDistCoeffs(const cv::Mat& coeffs);
+  void setCameraParams(const cv::Mat& camera_matrix, const cv::Mat& dist_coeffs);
+  void setCameraParamsFromCalibrator(const CameraCalibrator& calibrator);
+  
+  bool solvePnP(const std::vector<cv::Point2f>& image_points,
+                const std::vector<cv::Point3f>& world_points,
+                cv::Mat& rvec, cv::Mat& tvec);
+                
+  // 像素 -> 相机坐标系中深度为 z_world 的点。默认只做 K^-1 反投影（与原实现一致）；
+  // undistort 为 true 时先按畸变模型去畸变（输入为原始图像坐标）
+  cv::Point3f pixelToWorld(const cv::Point2f& pixel_point, float z_world = 0, bool undistort = false) const;
+  // 相机坐标系中的点 -> 像素（含畸变）；点不在相机前方时返回 (0, 0)
+  cv::Point2f worldToPixel(const cv::Point3f& world_point) const;
+  
+  // 批量版本：count 个点一次处理，不分配内存，x86 上 8 个一组走 AVX2。
+  // 流水线的重投影校验、叠加显示等每帧要投影大量点的场合使用
+  void pixelToWorld(const cv::Point2f* pixels, cv::Point3f* points, std::size_t count,
+                    float z_world = 0, bool undistort = false) const;
+  void worldToPixel(const cv::Point3f* points, cv::Point2f* pixels, std::size_t count) const;
+  // pixels / points 按需扩容后复用
+  void pixelToWorld(const std::vector<cv::Point2f>& pixels, std::vector<cv::Point3f>& points,
+                    float z_world = 0, bool undistort = false) const;
+  void worldToPixel(const std::vector<cv::Point3f>& points, std::vector<cv::Point2f>& pixels) const;
+  
+  cv::Mat getCameraMatrix() const { return camera_matrix_; }
+  cv::Mat getDistCoeffs() const { return dist_coeffs_; }
+  
+  // 批量投影使用的内参缓存（单精度），相机参数变化时更新
+  struct Intrinsics
+  {
+    float fx = 0.0f, fy = 0.0f, cx = 0.0f, cy = 0.0f;
+    float inv_fx = 0.0f, inv_fy = 0.0f;
+    float dist[8] = {};
+    bool has_distortion = false;
+  };
+  
+private:
+  // camera_matrix_ / dist_coeffs_ 变化后同步 model_ 与 intrinsics_
+  void updateIntrinsics();
+  
+  cv::Mat camera_matrix_;
+  cv::Mat dist_coeffs_;
+  CameraModel model_;          // 与 camera_matrix_ / dist_coeffs_ 同步，用于解析内参与畸变系数
+  Intrinsics intrinsics_;
+  bool params_initialized_ = false;
+};
+
+} // namespace rm_auto_aim
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <cstddef>
+#include <vector>
+#include "armor_detector/armor.hpp"
+#include "armor_detector/frame_arena.hpp"
+
+namespace rm_auto_aim {
+
+struct DetectorParams {
+    // 检测颜色: RED / BLUE
+    int detect_color = RED;
+    
+    // 每帧输出检测统计（无界面高帧率模式下关闭）
+    bool log_frames = true;
+    
+    // 红色HSV阈值（两个色相范围）
+    struct {
+        int h1_min = 0, h1_max = 10;
+        int h2_min = 160, h2_max = 180;
+        int s_min = 100, s_max = 255;
+        int v_min = 100, v_max = 255;
+    } hsv_red;
+    
+    // 灯条参数
+    struct {
+        float min_ratio = 0.1f;
+        float max_ratio = 0.4f;
+        float max_angle = 40.0f;
+        float min_area = 10.0f;
+        // 颜色判定只统计 preprocess 二值图中非零的像素（默认关闭，与逐像素判定结果一致）
+        bool color_vote_mask_only = false;
+    } light;
+    
+    // 装甲板参数（距离以平均灯条长度为单位）
+    struct {
+        float min_light_ratio = 0.7f;
+        float min_small_distance = 0.8f;
+        float max_small_distance = 3.2f;
+        float min_large_distance = 3.2f;
+        float max_large_distance = 5.5f;
+        float max_angle_diff = 10.0f;
+        float max_vertical_ratio = 0.5f;
+        float min_aspect_ratio = 1.0f;
+        float max_aspect_ratio = 5.0f;
+    } armor;
+    
+    // 跟踪窗口（ROI）检测参数
+    struct {
+        bool enable = true;
+        int full_scan_interval = 30;  // 每隔N帧强制全图检测一次，<=0 表示不强制
+        int min_size = 32;            // 窗口过小时直接全图检测（像素）
+    } roi;
+};
+
+class Detector {
+public:
+    struct DebugInfo {
+        int contours_found = 0;
+        int lights_found = 0;
+        int target_color_lights = 0;
+        int armors_found = 0;
+        double process_time_ms = 0.0;
+        double color_time_ms = 0.0;  // determineColor 累计耗时
+        std::size_t allocations = 0; // 本帧检测线程的堆分配次数（需以 RM_COUNT_ALLOCATIONS 编译）
+        double timestamp = -1.0;     // 本帧采集时间（秒），随结果传给 Tracker::update
+        
+        cv::Rect search_roi;      // 本帧实际检测的区域
+        bool full_frame = true;   // 是否为全图检测（含ROI未命中后的回退）
+    };
+    
+    explicit Detector(const DetectorParams& params);
+    
+    // 全图检测。返回的结果与中间图像都保存在检测器内部的复用缓冲中，
+    // 在下一次 detect 之前有效；同一分辨率下稳态运行时热路径不再分配内存
+    const std::vector<Armor>& detect(const cv::Mat& rgb_img);
+    // 在跟踪器给出的搜索窗口内检测；窗口为空、未命中或到达全图间隔时回退到全图。
+    // timestamp 为采集时间（秒），<0 时取进入 detect 时的单调时钟
+    const std::vector<Armor>& detect(const cv::Mat& rgb_img, const cv::Rect& roi_hint,
+                                     double timestamp = -1.0);
+    // 与 detect 相同，但结果放入帧池：句柄释放前一直有效，可交给其他线程使用
+    FrameHandle detectFrame(const cv::Mat& rgb_img, const cv::Rect& roi_hint = cv::Rect(),
+                            double timestamp = -1.0);
+    
+    cv::Mat preprocess(const cv::Mat& rgb_img);
+    void findLights(const cv::Mat& rgb_img, const cv::Mat& binary_img, std::vector<Light>& lights);
+    void matchLights(const std::vector<Light>& lights, std::vector<Armor>& armors);
+    
+    const DebugInfo& getDebugInfo() const { return debug_info_; }
+    const cv::Mat& getBinaryImage() const { return binary_img_; }
+    // detect 返回的装甲板中灯条下标所引用的数组
+    const std::vector<Light>& getTargetLights() const { return target_lights_; }
+    const DetectorParams& getParams() const { return params_; }
+    
+private:
+    void runDetection(const cv::Mat& rgb_img, const cv::Point& offset);
+    cv::Mat workBuffer(cv::Mat& storage, const cv::Size& size, int type);
+    bool isValidLight(const Light& light);
+    int determineColor(const cv::Mat& rgb_img, const cv::Mat& binary_img, const Light& light);
+    ArmorType isArmor(const Light& light1, const Light& light2);
+    // 下标 i、j 的灯条之间是否夹有其他灯条（lights 需已由 buildLightIndex 建立索引）
+    bool containLight(int i, int j, const std::vector<Light>& lights);
+    void buildLightIndex(const std::vector<Light>& lights);
+    
+    DetectorParams params_;
+    cv::Mat binary_img_;
+    std::vector<Light> lights_;
+    std::vector<Light> target_lights_;
+    std::vector<Armor> armors_;
+    
+    // 跨帧复用的工作缓冲
+    cv::Mat color_mask_buf_;
+    cv::Mat hsv_buf_;
+    cv::Mat range_buf_;
+    cv::Mat morph_buf_;
+    std::vector<std::vector<cv::Point>> contours_;
+    DebugInfo debug_info_;
+    int frames_since_full_scan_ = 0;
+    FrameArena arena_;
+    
+    // matchLights 使用的空间索引：按中心x排序的下标及对应x坐标
+    std::vector<int> light_order_;
+    std::vector<float> light_xs_;
+    float light_extent_ = 0.0f;
+    std::vector<std::pair<int, int>> light_pairs_;
+};
+
+} // namespace rm_auto_aim
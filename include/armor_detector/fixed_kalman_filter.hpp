@@ -0,0 +1,212 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <utility>
+
+namespace rm_auto_aim
+{
+// 编译期尺寸的小矩阵（行优先、float 存储），全部位于栈上
+template <int Rows, int Cols>
+struct FixedMatrix
+{
+  static constexpr int rows = Rows;
+  static constexpr int cols = Cols;
+
+  std::array<float, Rows * Cols> data{};
+
+  float& operator()(int r, int c) { return data[r * Cols + c]; }
+  float operator()(int r, int c) const { return data[r * Cols + c]; }
+  float& operator[](int i) { return data[i]; }
+  float operator[](int i) const { return data[i]; }
+
+  static FixedMatrix zeros() { return FixedMatrix(); }
+
+  static FixedMatrix identity(float scale = 1.0f)
+  {
+    FixedMatrix m;
+    for (int i = 0; i < Rows && i < Cols; ++i) {
+      m(i, i) = scale;
+    }
+    return m;
+  }
+};
+
+namespace kf_detail
+{
+// 与 cv::gemm 对 CV_32F 的处理一致：乘加在 double 中累积，结果写回 float
+// C = A * B
+template <int R, int K, int C>
+inline void multiply(const FixedMatrix<R, K>& a, const FixedMatrix<K, C>& b, FixedMatrix<R, C>& out)
+{
+  for (int i = 0; i < R; ++i) {
+    for (int j = 0; j < C; ++j) {
+      double sum = 0.0;
+      for (int k = 0; k < K; ++k) {
+        sum += static_cast<double>(a(i, k)) * b(k, j);
+      }
+      out(i, j) = static_cast<float>(sum);
+    }
+  }
+}
+
+// C = A * B^T + D
+template <int R, int K, int C>
+inline void multiplyTransposedAdd(const FixedMatrix<R, K>& a, const FixedMatrix<C, K>& b,
+                                  const FixedMatrix<R, C>& d, FixedMatrix<R, C>& out)
+{
+  for (int i = 0; i < R; ++i) {
+    for (int j = 0; j < C; ++j) {
+      double sum = 0.0;
+      for (int k = 0; k < K; ++k) {
+        sum += static_cast<double>(a(i, k)) * b(j, k);
+      }
+      out(i, j) = static_cast<float>(sum + d(i, j));
+    }
+  }
+}
+
+// 求解 S * X = B（S 为对称正定的新息协方差），在 double 中做带部分主元的高斯-约当消元
+template <int M, int N>
+inline bool solve(const FixedMatrix<M, M>& s, const FixedMatrix<M, N>& b, FixedMatrix<M, N>& x)
+{
+  double a[M][M];
+  double rhs[M][N];
+  for (int i = 0; i < M; ++i) {
+    for (int j = 0; j < M; ++j) a[i][j] = s(i, j);
+    for (int j = 0; j < N; ++j) rhs[i][j] = b(i, j);
+  }
+
+  for (int col = 0; col < M; ++col) {
+    int pivot = col;
+    for (int r = col + 1; r < M; ++r) {
+      if (std::abs(a[r][col]) > std::abs(a[pivot][col])) pivot = r;
+    }
+    if (a[pivot][col] == 0.0) {
+      return false;
+    }
+    if (pivot != col) {
+      for (int j = 0; j < M; ++j) std::swap(a[col][j], a[pivot][j]);
+      for (int j = 0; j < N; ++j) std::swap(rhs[col][j], rhs[pivot][j]);
+    }
+
+    const double inv = 1.0 / a[col][col];
+    for (int j = 0; j < M; ++j) a[col][j] *= inv;
+    for (int j = 0; j < N; ++j) rhs[col][j] *= inv;
+
+    for (int r = 0; r < M; ++r) {
+      if (r == col) continue;
+      const double factor = a[r][col];
+      if (factor == 0.0) continue;
+      for (int j = 0; j < M; ++j) a[r][j] -= factor * a[col][j];
+      for (int j = 0; j < N; ++j) rhs[r][j] -= factor * rhs[col][j];
+    }
+  }
+
+  for (int i = 0; i < M; ++i) {
+    for (int j = 0; j < N; ++j) x(i, j) = static_cast<float>(rhs[i][j]);
+  }
+  return true;
+}
+}  // namespace kf_detail
+
+// 编译期维度的线性卡尔曼滤波器，接口与字段命名对应 cv::KalmanFilter（无控制输入）。
+// 全部状态为定长数组，predict/correct 不分配内存；
+// 计算顺序与 cv::KalmanFilter 相同，结果在 float 精度内一致
+template <int StateDim, int MeasDim>
+class FixedKalmanFilter
+{
+public:
+  static constexpr int kStateDim = StateDim;
+  static constexpr int kMeasDim = MeasDim;
+
+  using StateVector = FixedMatrix<StateDim, 1>;
+  using MeasVector = FixedMatrix<MeasDim, 1>;
+  using StateMatrix = FixedMatrix<StateDim, StateDim>;
+  using MeasMatrix = FixedMatrix<MeasDim, StateDim>;
+  using MeasCovMatrix = FixedMatrix<MeasDim, MeasDim>;
+  using GainMatrix = FixedMatrix<StateDim, MeasDim>;
+
+  // 与 cv::KalmanFilter 构造后的默认值相同
+  FixedKalmanFilter()
+  : transitionMatrix(StateMatrix::identity()),
+    processNoiseCov(StateMatrix::identity()),
+    measurementNoiseCov(MeasCovMatrix::identity())
+  {
+  }
+
+  // x' = A x，P' = A P A^T + Q
+  const StateVector& predict()
+  {
+    kf_detail::multiply(transitionMatrix, statePost, statePre);
+
+    StateMatrix temp1;
+    kf_detail::multiply(transitionMatrix, errorCovPost, temp1);
+    kf_detail::multiplyTransposedAdd(temp1, transitionMatrix, processNoiseCov, errorCovPre);
+
+    statePost = statePre;
+    errorCovPost = errorCovPre;
+    return statePre;
+  }
+
+  // K = P H^T (H P H^T + R)^-1，x = x' + K (z - H x')，P = P' - K H P'
+  const StateVector& correct(const MeasVector& measurement)
+  {
+    FixedMatrix<MeasDim, StateDim> temp2;
+    kf_detail::multiply(measurementMatrix, errorCovPre, temp2);
+
+    MeasCovMatrix temp3;
+    kf_detail::multiplyTransposedAdd(temp2, measurementMatrix, measurementNoiseCov, temp3);
+
+    FixedMatrix<MeasDim, StateDim> temp4;
+    if (!kf_detail::solve(temp3, temp2, temp4)) {
+      return statePost;
+    }
+    for (int i = 0; i < StateDim; ++i) {
+      for (int j = 0; j < MeasDim; ++j) {
+        gain(i, j) = temp4(j, i);
+      }
+    }
+
+    // 新息 z - H x'
+    MeasVector temp5;
+    for (int i = 0; i < MeasDim; ++i) {
+      double sum = 0.0;
+      for (int k = 0; k < StateDim; ++k) {
+        sum += static_cast<double>(measurementMatrix(i, k)) * statePre[k];
+      }
+      temp5[i] = static_cast<float>(measurement[i] - sum);
+    }
+
+    for (int i = 0; i < StateDim; ++i) {
+      double sum = 0.0;
+      for (int j = 0; j < MeasDim; ++j) {
+        sum += static_cast<double>(gain(i, j)) * temp5[j];
+      }
+      statePost[i] = static_cast<float>(statePre[i] + sum);
+    }
+
+    for (int i = 0; i < StateDim; ++i) {
+      for (int j = 0; j < StateDim; ++j) {
+        double sum = 0.0;
+        for (int k = 0; k < MeasDim; ++k) {
+          sum += static_cast<double>(gain(i, k)) * temp2(k, j);
+        }
+        errorCovPost(i, j) = static_cast<float>(errorCovPre(i, j) - sum);
+      }
+    }
+    return statePost;
+  }
+
+  StateVector statePre;
+  StateVector statePost;
+  StateMatrix transitionMatrix;
+  MeasMatrix measurementMatrix;
+  StateMatrix processNoiseCov;
+  MeasCovMatrix measurementNoiseCov;
+  StateMatrix errorCovPre;
+  GainMatrix gain;
+  StateMatrix errorCovPost;
+};
+
+}  // namespace rm_auto_aim
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "armor_detector/armor.hpp"
+
+namespace rm_auto_aim {
+
+// 一帧的检测结果：灯条与装甲板连续存放，装甲板通过下标引用 lights 中的灯条
+struct DetectionFrame {
+    std::uint64_t frame_id = 0;
+    double timestamp = -1.0;      // 采集时间（秒）
+    cv::Rect search_roi;          // 本帧实际检测的区域
+    bool full_frame = true;
+
+    std::vector<Light> lights;    // 目标颜色灯条
+    std::vector<Armor> armors;
+
+    const Light& leftLight(const Armor& armor) const { return lights[armor.left_light]; }
+    const Light& rightLight(const Armor& armor) const { return lights[armor.right_light]; }
+
+    void clear() {
+        frame_id = 0;
+        timestamp = -1.0;
+        search_roi = cv::Rect();
+        full_frame = true;
+        lights.clear();   // 保留容量，复用时不重新分配
+        armors.clear();
+    }
+};
+
+class FrameArena;
+
+// 帧句柄：持有期间结果保持有效，最后一个句柄释放后帧槽回到池中。
+// 复制/释放只做原子计数，可以在线程之间传递；FrameArena 必须比所有句柄活得久
+class FrameHandle {
+public:
+    FrameHandle() = default;
+    FrameHandle(const FrameHandle& other);
+    FrameHandle(FrameHandle&& other) noexcept;
+    FrameHandle& operator=(const FrameHandle& other);
+    FrameHandle& operator=(FrameHandle&& other) noexcept;
+    ~FrameHandle() { release(); }
+
+    void release();
+
+    explicit operator bool() const { return slot_ != nullptr; }
+    const DetectionFrame* get() const;
+    const DetectionFrame* operator->() const { return get(); }
+    const DetectionFrame& operator*() const { return *get(); }
+
+    // 写入结果用，只应在帧发布给其他线程之前调用
+    DetectionFrame* edit();
+
+private:
+    friend class FrameArena;
+    struct Slot;
+    FrameHandle(FrameArena* arena, Slot* slot) : arena_(arena), slot_(slot) {}
+
+    FrameArena* arena_ = nullptr;
+    Slot* slot_ = nullptr;
+};
+
+// 检测结果帧池：帧槽按需增长，之后循环复用，稳态下取帧/写入/释放都不分配内存
+class FrameArena {
+public:
+    explicit FrameArena(std::size_t initial_frames = 4,
+                        std::size_t light_capacity = 64,
+                        std::size_t armor_capacity = 16);
+    ~FrameArena();
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    // 取出一个空帧并分配帧号；池中无空闲帧时新建一个
+    FrameHandle acquire();
+
+    std::size_t capacity() const;
+    std::size_t inUse() const;
+
+private:
+    friend class FrameHandle;
+    void recycle(FrameHandle::Slot* slot);
+    FrameHandle::Slot* createSlot();
+
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<FrameHandle::Slot>> slots_;
+    std::vector<FrameHandle::Slot*> free_;
+    std::size_t light_capacity_;
+    std::size_t armor_capacity_;
+    std::uint64_t next_frame_id_ = 1;
+};
+
+struct FrameHandle::Slot {
+    DetectionFrame frame;
+    std::atomic<int> refs{0};
+};
+
+} // namespace rm_auto_aim
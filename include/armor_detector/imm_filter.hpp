@@ -0,0 +1,312 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <opencv2/opencv.hpp>
+#include "armor_detector/fixed_kalman_filter.hpp"
+#include "armor_detector/motion_filter.hpp"
+
+namespace rm_auto_aim
+{
+// IMM 中可用的运动模型。被模型置零的分量，其方差重置为初始方差，
+// 混合到其他模型时不会把这些分量锁死在 0
+enum class MotionModel
+{
+  CONSTANT_VELOCITY,      // 匀速，加速度分量每步置零
+  CONSTANT_ACCELERATION,  // 匀加速
+  STATIONARY              // 近似静止，速度与加速度每步置零
+};
+
+// 噪声参数（像素、秒）
+struct ImmNoiseParams
+{
+  float measurement_var = 4.0f;       // 观测方差（px^2）
+  float cv_accel_std = 300.0f;        // 匀速模型的加速度扰动（px/s^2）
+  float ca_jerk_std = 3000.0f;        // 匀加速模型的加加速度扰动（px/s^3）
+  float stationary_pos_std = 10.0f;   // 静止模型的位置随机游走（px/sqrt(s)）
+  float initial_vel_std = 500.0f;     // 初始化时的速度标准差（px/s）
+  float initial_acc_std = 1000.0f;    // 初始化时的加速度标准差（px/s^2）
+  float stay_probability = 0.95f;     // 模型转移矩阵对角元素
+};
+
+// 交互多模型（IMM）滤波器。
+//
+// 各模型共用状态 (x, vx, ax, y, vy, ay) 与观测 (x, y)，每个模型是一个 FixedKalmanFilter<6, 2>。
+// 每步：按模型转移概率混合各模型的状态与协方差 -> 各模型独立预测 -> 各自校正并计算观测似然
+// -> 更新模型概率 -> 按概率加权输出组合估计。
+// 模型数为模板参数，全部为定长数组，predict/update 不分配内存。
+template <int NumModels>
+class ImmFilter
+{
+public:
+  static constexpr int kStateDim = 6;
+  static constexpr int kMeasDim = 2;
+  static constexpr int kNumModels = NumModels;
+
+  using Filter = FixedKalmanFilter<kStateDim, kMeasDim>;
+  using StateVector = typename Filter::StateVector;
+  using StateMatrix = typename Filter::StateMatrix;
+
+  explicit ImmFilter(const std::array<MotionModel, NumModels>& models,
+                     const ImmNoiseParams& params = ImmNoiseParams())
+  : models_(models), params_(params)
+  {
+    const float stay = NumModels > 1 ? params_.stay_probability : 1.0f;
+    const float leave = NumModels > 1 ? (1.0f - stay) / (NumModels - 1) : 0.0f;
+    for (int i = 0; i < NumModels; ++i) {
+      for (int j = 0; j < NumModels; ++j) {
+        transition_(i, j) = (i == j) ? stay : leave;
+      }
+    }
+
+    for (auto& filter : filters_) {
+      filter.measurementMatrix = Filter::MeasMatrix::zeros();
+      filter.measurementMatrix(0, 0) = 1.0f;
+      filter.measurementMatrix(1, 3) = 1.0f;
+      filter.measurementNoiseCov = Filter::MeasCovMatrix::identity(params_.measurement_var);
+    }
+    init(cv::Point2f(0, 0));
+  }
+
+  void init(const cv::Point2f& pos)
+  {
+    StateVector x = StateVector::zeros();
+    x[0] = pos.x;
+    x[3] = pos.y;
+
+    StateMatrix p = StateMatrix::zeros();
+    const float vel_var = params_.initial_vel_std * params_.initial_vel_std;
+    const float acc_var = params_.initial_acc_std * params_.initial_acc_std;
+    for (int axis = 0; axis < 2; ++axis) {
+      const int o = axis * 3;
+      p(o, o) = params_.measurement_var;
+      p(o + 1, o + 1) = vel_var;
+      p(o + 2, o + 2) = acc_var;
+    }
+
+    for (auto& filter : filters_) {
+      filter.statePost = filter.statePre = x;
+      filter.errorCovPost = filter.errorCovPre = p;
+    }
+    mu_.fill(1.0f / NumModels);
+    combine();
+  }
+
+  // 所有模型前进 dt 秒
+  void predict(float dt)
+  {
+    // 1. 混合：c_j = sum_i p_ij mu_i，mu_{i|j} = p_ij mu_i / c_j
+    std::array<float, NumModels> c;
+    for (int j = 0; j < NumModels; ++j) {
+      double sum = 0.0;
+      for (int i = 0; i < NumModels; ++i) {
+        sum += static_cast<double>(transition_(i, j)) * mu_[i];
+      }
+      c[j] = static_cast<float>(sum);
+    }
+
+    std::array<StateVector, NumModels> mixed_x;
+    std::array<StateMatrix, NumModels> mixed_p;
+    for (int j = 0; j < NumModels; ++j) {
+      std::array<float, NumModels> w;
+      for (int i = 0; i < NumModels; ++i) {
+        w[i] = c[j] > 0.0f ? transition_(i, j) * mu_[i] / c[j] : (i == j ? 1.0f : 0.0f);
+      }
+      mixState(w, mixed_x[j], mixed_p[j]);
+    }
+
+    // 2. 各模型从混合后的初值独立预测
+    for (int j = 0; j < NumModels; ++j) {
+      Filter& filter = filters_[j];
+      filter.statePost = mixed_x[j];
+      filter.errorCovPost = mixed_p[j];
+      setModel(filter, models_[j], dt);
+      filter.predict();
+    }
+
+    // 没有观测时模型概率即为预测概率
+    mu_ = c;
+    combine();
+  }
+
+  // 用位置观测校正所有模型并更新模型概率；未经 predict 时以当前状态为先验
+  void update(const cv::Point2f& z)
+  {
+    std::array<double, NumModels> likelihood;
+    double total = 0.0;
+    for (int j = 0; j < NumModels; ++j) {
+      Filter& filter = filters_[j];
+      filter.statePre = filter.statePost;
+      filter.errorCovPre = filter.errorCovPost;
+
+      // 新息 nu = z - H x'，S = H P' H^T + R
+      const double nu_x = z.x - filter.statePre[0];
+      const double nu_y = z.y - filter.statePre[3];
+      const double s00 = static_cast<double>(filter.errorCovPre(0, 0)) + filter.measurementNoiseCov(0, 0);
+      const double s01 = static_cast<double>(filter.errorCovPre(0, 3)) + filter.measurementNoiseCov(0, 1);
+      const double s11 = static_cast<double>(filter.errorCovPre(3, 3)) + filter.measurementNoiseCov(1, 1);
+      const double det = s00 * s11 - s01 * s01;
+
+      likelihood[j] = 0.0;
+      if (det > 0.0) {
+        const double d2 = (s11 * nu_x * nu_x - 2.0 * s01 * nu_x * nu_y + s00 * nu_y * nu_y) / det;
+        likelihood[j] = std::exp(-0.5 * d2) / (6.283185307179586 * std::sqrt(det));
+      }
+      total += likelihood[j] * mu_[j];
+
+      typename Filter::MeasVector measurement;
+      measurement[0] = z.x;
+      measurement[1] = z.y;
+      filter.correct(measurement);
+    }
+
+    // 所有模型的似然都下溢时保持原概率
+    if (total > 0.0) {
+      for (int j = 0; j < NumModels; ++j) {
+        mu_[j] = static_cast<float>(likelihood[j] * mu_[j] / total);
+      }
+    }
+    combine();
+  }
+
+  // 组合估计（按模型概率加权）
+  const StateVector& state() const { return x_; }
+  const StateMatrix& covariance() const { return p_; }
+  float probability(int j) const { return mu_[j]; }
+  MotionModel model(int j) const { return models_[j]; }
+
+  // 组合估计下的新息协方差
+  cv::Matx22f innovationCov() const
+  {
+    return cv::Matx22f(p_(0, 0) + params_.measurement_var, p_(0, 3),
+                       p_(3, 0), p_(3, 3) + params_.measurement_var);
+  }
+
+private:
+  // 按权重 w 合成各模型的状态：x = sum w_i x_i，P = sum w_i (P_i + (x_i - x)(x_i - x)^T)
+  void mixState(const std::array<float, NumModels>& w, StateVector& x, StateMatrix& p) const
+  {
+    for (int k = 0; k < kStateDim; ++k) {
+      double sum = 0.0;
+      for (int i = 0; i < NumModels; ++i) {
+        sum += static_cast<double>(w[i]) * filters_[i].statePost[k];
+      }
+      x[k] = static_cast<float>(sum);
+    }
+
+    for (int r = 0; r < kStateDim; ++r) {
+      for (int col = r; col < kStateDim; ++col) {
+        double sum = 0.0;
+        for (int i = 0; i < NumModels; ++i) {
+          const auto& xi = filters_[i].statePost;
+          const double dr = static_cast<double>(xi[r]) - x[r];
+          const double dc = static_cast<double>(xi[col]) - x[col];
+          sum += w[i] * (filters_[i].errorCovPost(r, col) + dr * dc);
+        }
+        p(r, col) = p(col, r) = static_cast<float>(sum);
+      }
+    }
+  }
+
+  void combine() { mixState(mu_, x_, p_); }
+
+  // 按模型与 dt 设置单轴 3x3 块的 F 和 Q（两轴相同）
+  void setModel(Filter& filter, MotionModel model, float dt) const
+  {
+    filter.transitionMatrix = StateMatrix::zeros();
+    filter.processNoiseCov = StateMatrix::zeros();
+
+    const float t2 = dt * dt;
+    const float t3 = t2 * dt;
+    const float vel_var = params_.initial_vel_std * params_.initial_vel_std;
+    const float acc_var = params_.initial_acc_std * params_.initial_acc_std;
+    for (int axis = 0; axis < 2; ++axis) {
+      const int o = axis * 3;
+      auto& F = filter.transitionMatrix;
+      auto& Q = filter.processNoiseCov;
+
+      switch (model) {
+        case MotionModel::CONSTANT_VELOCITY: {
+          // 加速度不参与传播，离散白噪声加速度模型
+          const float q = params_.cv_accel_std * params_.cv_accel_std;
+          F(o, o) = 1.0f;
+          F(o, o + 1) = dt;
+          F(o + 1, o + 1) = 1.0f;
+          Q(o, o) = t3 * dt / 4.0f * q;
+          Q(o, o + 1) = Q(o + 1, o) = t3 / 2.0f * q;
+          Q(o + 1, o + 1) = t2 * q;
+          Q(o + 2, o + 2) = acc_var;
+          break;
+        }
+        case MotionModel::CONSTANT_ACCELERATION: {
+          // 离散白噪声加加速度模型
+          const float q = params_.ca_jerk_std * params_.ca_jerk_std;
+          F(o, o) = 1.0f;
+          F(o, o + 1) = dt;
+          F(o, o + 2) = 0.5f * t2;
+          F(o + 1, o + 1) = 1.0f;
+          F(o + 1, o + 2) = dt;
+          F(o + 2, o + 2) = 1.0f;
+          const float g[3] = {t3 / 6.0f, t2 / 2.0f, dt};
+          for (int r = 0; r < 3; ++r) {
+            for (int col = 0; col < 3; ++col) {
+              Q(o + r, o + col) = g[r] * g[col] * q;
+            }
+          }
+          break;
+        }
+        case MotionModel::STATIONARY: {
+          // 位置保持，随机游走
+          F(o, o) = 1.0f;
+          Q(o, o) = params_.stationary_pos_std * params_.stationary_pos_std * dt;
+          Q(o + 1, o + 1) = vel_var;
+          Q(o + 2, o + 2) = acc_var;
+          break;
+        }
+      }
+    }
+  }
+
+  std::array<Filter, NumModels> filters_;
+  std::array<MotionModel, NumModels> models_;
+  std::array<float, NumModels> mu_;
+  FixedMatrix<NumModels, NumModels> transition_;
+  ImmNoiseParams params_;
+
+  StateVector x_;
+  StateMatrix p_;
+};
+
+// 匀速 / 匀加速 / 近似静止三模型 IMM，实现 MotionFilter 接口，可替代 KalmanFilter 用于 Tracker
+class ImmKalmanFilter : public MotionFilter
+{
+public:
+  explicit ImmKalmanFilter(const ImmNoiseParams& params = ImmNoiseParams());
+
+  void init(const cv::Point2f& initial_pos, double timestamp = -1.0) override;
+  cv::Point2f predict(double timestamp) override;
+  void update(const cv::Point2f& measurement) override;
+
+  cv::Point2f predictAt(double timestamp) const override;
+
+  bool isInitialized() const override { return initialized_; }
+  cv::Point2f getPrediction() const override;
+  cv::Point2f getVelocity() const override;
+  float getDt() const override { return dt_; }
+  cv::Matx22f getInnovationCov() const override { return imm_.innovationCov(); }
+
+  // 各模型当前概率（顺序：匀速、匀加速、静止）
+  float getModelProbability(int model) const { return imm_.probability(model); }
+
+private:
+  ImmFilter<3> imm_;
+  bool initialized_ = false;
+  float dt_ = 0.033f;
+  double last_timestamp_ = -1.0;
+
+  static constexpr float nominalDt_ = 0.033f;
+  static constexpr float minDt_ = 1e-4f;
+  static constexpr float maxDt_ = 0.5f;
+};
+
+}  // namespace rm_auto_aim
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+namespace rm_auto_aim {
+
+// 单位四元数 (w, x, y, z)，表示把云台系向量旋转到世界系的姿态
+struct Quaternion {
+    double w = 1.0, x = 0.0, y = 0.0, z = 0.0;
+
+    Quaternion() = default;
+    Quaternion(double w_, double x_, double y_, double z_) : w(w_), x(x_), y(y_), z(z_) {}
+
+    // ZYX 欧拉角（弧度）：先绕 z 轴 yaw，再绕 y 轴 pitch，最后绕 x 轴 roll
+    static Quaternion fromEuler(double yaw, double pitch, double roll);
+    // 球面线性插值，ratio 超出 [0, 1] 时沿同一大圆外推
+    static Quaternion slerp(const Quaternion& a, const Quaternion& b, double ratio);
+
+    Quaternion normalized() const;
+    Quaternion operator*(const Quaternion& other) const;
+    cv::Matx33d toRotationMatrix() const;
+};
+
+// IMU 姿态采样：timestamp 与图像时间戳同一时钟（秒）
+struct ImuSample {
+    double timestamp = 0.0;
+    Quaternion orientation;
+};
+
+// 刚体变换 p_dst = rotation * p_src + translation
+struct RigidTransform {
+    cv::Matx33d rotation = cv::Matx33d::eye();
+    cv::Vec3d translation = cv::Vec3d(0, 0, 0);
+
+    cv::Vec3d apply(const cv::Vec3d& point) const { return rotation * point + translation; }
+    RigidTransform operator*(const RigidTransform& other) const;
+    // 把物体在源坐标系下的位姿 (rvec, tvec) 变换到目标坐标系
+    void transformPose(const cv::Vec3d& rvec, const cv::Vec3d& tvec,
+                       cv::Vec3d& out_rvec, cv::Vec3d& out_tvec) const;
+};
+
+// 相机相对云台的安装关系：相机光学系 (x 右, y 下, z 前) -> 云台系 (x 前, y 左, z 上)
+struct CameraMount {
+    RigidTransform camera_to_gimbal = opticalToGimbal();
+    // 图像时间戳 + time_offset = 对应的 IMU 时间（曝光中点与触发时刻之差、两路时钟的固定偏差）
+    double time_offset = 0.0;
+
+    // 光轴与云台 x 轴重合、无安装偏移时的轴变换
+    static RigidTransform opticalToGimbal();
+};
+
+// 按时间戳索引的云台姿态环形缓冲。
+// 单个写线程（串口/IMU 驱动，约 1 kHz）调用 push，任意多个读线程按图像时间戳查询插值后的姿态。
+// 每个槽位带一个序号（seqlock）：写线程先把序号置为奇数、写入数据、再置为偶数，
+// 读线程在读取前后比较序号，被覆盖的槽位视为已过期。写线程从不等待读线程，读线程也不加锁。
+// 查询在有效区间内二分，O(log n)。
+class ImuPoseBuffer {
+public:
+    // capacity 向上取整到 2 的幂；默认约 2 秒的 1 kHz 采样
+    explicit ImuPoseBuffer(std::size_t capacity = 2048);
+
+    ImuPoseBuffer(const ImuPoseBuffer&) = delete;
+    ImuPoseBuffer& operator=(const ImuPoseBuffer&) = delete;
+
+    // 写线程：时间戳须严格递增，否则丢弃并返回 false
+    bool push(const ImuSample& sample);
+    bool push(double timestamp, const Quaternion& orientation) { return push(ImuSample{timestamp, orientation}); }
+
+    // 读线程：timestamp 时刻的姿态（相邻两个采样之间 slerp）。
+    // 早于缓冲中最旧的采样，或晚于最新采样超过 max_extrapolation_ 时返回 false
+    bool lookup(double timestamp, Quaternion& orientation) const;
+    // timestamp 时刻相机光学系 -> 世界系的变换：云台姿态 * 相机安装关系
+    bool cameraToWorld(double timestamp, const CameraMount& mount, RigidTransform& transform) const;
+
+    // 最新一个采样，缓冲为空时返回 false
+    bool latest(ImuSample& sample) const;
+    std::size_t size() const;
+    std::size_t capacity() const { return capacity_; }
+    void clear();
+
+    void setMaxExtrapolation(double seconds) { max_extrapolation_ = seconds; }
+    double getMaxExtrapolation() const { return max_extrapolation_; }
+
+private:
+    struct Slot {
+        std::atomic<std::uint64_t> sequence{0};
+        std::atomic<double> timestamp{0.0};
+        std::atomic<double> w{1.0}, x{0.0}, y{0.0}, z{0.0};
+    };
+
+    // 读取第 index 个采样（单调递增的逻辑序号），槽位已被覆盖或正在写入时返回 false
+    bool read(std::uint64_t index, ImuSample& sample) const;
+    // 读取时间戳，槽位失效时返回 false
+    bool readTimestamp(std::uint64_t index, double& timestamp) const;
+
+    std::size_t capacity_;
+    std::size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+
+    // 写线程私有
+    double last_timestamp_ = 0.0;
+    // 已写入的采样数，写线程 release、读线程 acquire
+    alignas(64) std::atomic<std::uint64_t> count_{0};
+
+    // 帧时间戳可能略晚于最新的 IMU 采样（串口延迟），允许短时外推（秒）
+    double max_extrapolation_ = 0.005;
+    // 二分时避开即将被覆盖的最旧几个槽位
+    static constexpr std::uint64_t overwrite_guard_ = 4;
+};
+
+// 从文件回放 IMU 姿态，本地调试时代替电控串口。
+// 每行一个采样：`timestamp qw qx qy qz` 或 `timestamp yaw pitch roll`（弧度，ZYX），# 开头为注释
+class ImuReplaySource {
+public:
+    ImuReplaySource() = default;
+    ~ImuReplaySource();
+
+    ImuReplaySource(const ImuReplaySource&) = delete;
+    ImuReplaySource& operator=(const ImuReplaySource&) = delete;
+
+    bool load(const std::string& path);
+
+    // 在后台线程把采样写入 buffer，时间戳平移为 time_base + (t - t0)。
+    // realtime 为 true 时按记录的间隔写入（相机输入，time_base 取当前单调时钟）；
+    // 为 false 时一次写完（视频文件输入，time_base 通常为 0，buffer 容量需覆盖整个文件）
+    bool start(ImuPoseBuffer& buffer, double time_base, bool realtime = true);
+    void stop();
+    bool isRunning() const { return running_.load(std::memory_order_acquire); }
+
+    std::size_t size() const { return samples_.size(); }
+    // 记录的时长（秒）
+    double duration() const;
+
+private:
+    void run(ImuPoseBuffer* buffer, double time_base, bool realtime);
+
+    std::vector<ImuSample> samples_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+};
+
+} // namespace rm_auto_aim
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include "armor_detector/fixed_kalman_filter.hpp"
+#include "armor_detector/motion_filter.hpp"
+
+namespace rm_auto_aim
+{
+// 匀速模型卡尔曼滤波（状态 x, vx, y, vy）
+class KalmanFilter : public MotionFilter
+{
+public:
+  KalmanFilter();
+  // timestamp 为采集时间（秒），<0 表示未知
+  void init(const cv::Point2f& initial_pos, double timestamp = -1.0) override;
+  // 沿用最近一次的 dt 预测（初始为标称 33ms）
+  cv::Point2f predict();
+  // 按与上一时刻的实际间隔预测：每步以测得的 dt 重建 F 和 Q
+  cv::Point2f predict(double timestamp) override;
+  void update(const cv::Point2f& measurement) override;
+  
+  // 外推到任意时刻 t 的位置（匀速模型），不改变滤波器状态
+  cv::Point2f predictAt(double timestamp) const override;
+  double getTimestamp() const { return last_timestamp_; }
+  
+  bool isInitialized() const override { return initialized_; }
+  cv::Point2f getPrediction() const override { return prediction_; }
+  // 速度估计（像素/秒）与最近一次状态转移使用的时间步长（秒）
+  cv::Point2f getVelocity() const override;
+  // 当前状态下位置观测的新息协方差 S = H P H^T + R（像素^2）
+  cv::Matx22f getInnovationCov() const override;
+  float getDt() const override { return dt_; }
+
+private:
+  bool initialized_ = false;
+  cv::Point2f prediction_;
+  float dt_ = 0.033f;  // 30fps
+  
+  // Q 按 dt 线性缩放（随机游走噪声随时间累积），标称 dt 下与原参数一致
+  static constexpr float nominalDt_ = 0.033f;
+  static constexpr float minDt_ = 1e-4f;
+  static constexpr float maxDt_ = 0.5f;   // 长时间丢帧时限制外推步长
+  double last_timestamp_ = -1.0;
+  
+  static constexpr int stateSize_ = 4;
+  static constexpr int measSize_ = 2;
+  // 定长矩阵实现，predict/update 不分配内存
+  FixedKalmanFilter<stateSize_, measSize_> kf_;
+  FixedKalmanFilter<stateSize_, measSize_>::MeasVector measurement_;
+  
+  void initKalmanFilter();
+  void setTransition(float dt);
+};
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+namespace rm_auto_aim {
+
+// 端到端延迟统计（毫秒）
+struct LatencyStats {
+    std::uint64_t samples = 0;
+    double last_ms = 0.0;
+    double smoothed_ms = 0.0;
+    double mean_ms = 0.0;
+    double min_ms = 0.0;
+    double max_ms = 0.0;
+    double actuation_delay_ms = 0.0;
+    double lead_time_ms = 0.0;        // 当前施加的补偿量 = smoothed_ms + actuation_delay_ms
+};
+
+// 延迟补偿：记录每帧从采集到输出的实测延迟，指数平滑后加上可配置的执行延迟
+// （串口传输、电控响应），得到瞄准点需要外推的提前量。
+// addSample 与 getLeadTime 可在不同线程调用：平滑值为原子变量，统计量由互斥锁保护。
+class LatencyCompensator {
+public:
+    // smoothing 为指数平滑系数（0~1，越大越跟随最新样本）
+    explicit LatencyCompensator(double smoothing = 0.1, double actuation_delay_s = 0.0);
+
+    // 记录一帧的实测延迟（秒）；超过 max_sample_s_ 的样本（卡顿）只计入统计，不参与平滑
+    void addSample(double latency_s);
+    // 从采集时刻到执行时刻的提前量（秒）
+    double getLeadTime() const {
+        return smoothed_s_.load(std::memory_order_relaxed) + actuation_delay_s_.load(std::memory_order_relaxed);
+    }
+
+    void setActuationDelay(double delay_s) { actuation_delay_s_.store(delay_s, std::memory_order_relaxed); }
+    double getActuationDelay() const { return actuation_delay_s_.load(std::memory_order_relaxed); }
+
+    LatencyStats getStats() const;
+    void reset();
+
+private:
+    double smoothing_;
+    std::atomic<double> smoothed_s_{0.0};
+    std::atomic<double> actuation_delay_s_{0.0};
+
+    mutable std::mutex mutex_;
+    std::uint64_t samples_ = 0;
+    double last_s_ = 0.0;
+    double sum_s_ = 0.0;
+    double min_s_ = 0.0;
+    double max_s_ = 0.0;
+
+    static constexpr double max_sample_s_ = 0.5;
+};
+
+} // namespace rm_auto_aim
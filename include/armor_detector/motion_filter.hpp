@@ -0,0 +1,30 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+
+namespace rm_auto_aim
+{
+// Tracker 使用的图像平面运动滤波器接口（位置单位：像素，时间单位：秒）
+class MotionFilter
+{
+public:
+  virtual ~MotionFilter() = default;
+
+  // timestamp 为采集时间（秒），<0 表示未知
+  virtual void init(const cv::Point2f& initial_pos, double timestamp) = 0;
+  // 按与上一时刻的实际间隔预测
+  virtual cv::Point2f predict(double timestamp) = 0;
+  virtual void update(const cv::Point2f& measurement) = 0;
+
+  // 外推到任意时刻 t 的位置，不改变滤波器状态
+  virtual cv::Point2f predictAt(double timestamp) const = 0;
+
+  virtual bool isInitialized() const = 0;
+  virtual cv::Point2f getPrediction() const = 0;
+  virtual cv::Point2f getVelocity() const = 0;
+  virtual float getDt() const = 0;
+  // 当前状态下位置观测的新息协方差 S = H P H^T + R（像素^2）
+  virtual cv::Matx22f getInnovationCov() const = 0;
+};
+
+}  // namespace rm_auto_aim
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "armor_detector/armor.hpp"
+#include "armor_detector/assignment.hpp"
+#include "armor_detector/batched_kalman_filter.hpp"
+#include "armor_detector/pnp_solver.hpp"
+#include "armor_detector/tracker.hpp"
+
+namespace rm_auto_aim {
+
+// 多目标跟踪中的一条轨迹
+struct Track {
+    std::uint32_t id = 0;               // 稳定编号，轨迹存续期间不变
+    Tracker::State state = Tracker::DETECTING;
+    Armor armor;                        // 最近一次匹配到的装甲板
+    cv::Point2f predicted_position;     // 本帧预测位置（匹配后为校正后的位置）
+    int detect_count = 0;
+    int lost_count = 0;
+    int detection = -1;                 // 本帧匹配到的检测在 update() 输入中的下标，未匹配为 -1
+    PnPResult pose;                     // 本帧解算的位姿，本帧未命中时无效
+    PnPResult last_pose;                // 上一帧的位姿，与 pose 一起外推下一帧的参考姿态
+
+    bool isConfirmed() const { return state == Tracker::TRACKING || state == Tracker::TEMP_LOST; }
+};
+
+// 多目标跟踪器：每个可见装甲板一条轨迹，每帧用匈牙利算法对
+// 轨迹 x 检测 的代价矩阵（Tracker::matchScore）做全局最优分配。
+// 每条轨迹预测后按新息协方差计算一次马氏距离门限，门外的组合不参与分配。
+// 轨迹生命周期与 Tracker 的状态机一致：DETECTING 连续命中 tracking_thres_ 帧后确认，
+// 确认后连续丢失 lost_thres_ 帧进入 TEMP_LOST，2 * lost_thres_ 帧后删除。
+// 所有轨迹的卡尔曼滤波放在 BatchedKalmanFilter 中批量预测。
+// 打击目标在已确认的轨迹中选择，原目标丢失时立即切换到另一条已确认轨迹。
+class MultiTracker {
+public:
+    MultiTracker();
+
+    // timestamp 为帧的采集时间（秒）；<0 时按标称帧间隔推进
+    void update(const std::vector<Armor>& armors, double timestamp = -1.0);
+    void reset();
+
+    const std::vector<Track>& getTracks() const { return tracks_; }
+    // 当前打击目标，没有已确认轨迹时返回 nullptr
+    const Track* getTarget() const;
+    // 外推轨迹在时刻 t（秒）的图像位置，不改变状态
+    cv::Point2f predictAt(const Track& track, double timestamp) const;
+
+    // 解算本帧命中轨迹的位姿：已有位姿的轨迹逐条 PnPSolver::solveTracked，
+    // 还没有位姿的（新轨迹、丢失后重新命中）一次 PnPSolver::solveBatch；未命中的轨迹位姿置为无效
+    void solvePoses(const PnPSolver& solver);
+
+    // 所有已确认轨迹搜索窗口的外接矩形，供 Detector::detect(frame, roi_hint) 使用
+    cv::Rect getSearchRoi(const cv::Size& image_size) const;
+
+    // 选择新目标时参考的图像中心
+    void setImageCenter(const cv::Point2f& center) { image_center_ = center; }
+
+private:
+    void associate(const std::vector<Armor>& armors);
+    void removeTrack(int index);
+    void selectTarget();
+
+    std::vector<Track> tracks_;          // tracks_[i] 对应 kf_ 中的第 i 个目标
+    BatchedKalmanFilter kf_;
+    AssignmentSolver solver_;
+
+    // 每帧复用的工作区
+    std::vector<float> cost_;
+    std::vector<int> track_to_detection_;
+    std::vector<char> detection_matched_;
+    std::vector<int> cold_tracks_;         // solvePoses：没有位姿、走批量解算的轨迹下标
+    std::vector<Armor> cold_armors_;
+    std::vector<PnPResult> cold_poses_;
+
+    std::uint32_t next_id_ = 1;
+    std::uint32_t target_id_ = 0;        // 0 表示没有目标
+    double last_timestamp_ = -1.0;
+    float last_dt_ = 0.033f;
+    cv::Point2f image_center_ = cv::Point2f(640, 360);
+
+    int tracking_thres_ = 5;
+    int lost_thres_ = 5;
+    float gate_chi2_ = Tracker::default_gate_chi2_;
+    float gate_motion_std_ = Tracker::default_gate_motion_std_;
+    float roi_scale_ = 1.0f;
+    static constexpr double nominal_frame_interval_ = 0.033;
+    static constexpr float max_dt_ = 0.5f;
+    static constexpr std::size_t max_tracks_ = 64;
+};
+
+} // namespace rm_auto_aim
@@ -0,0 +1,12 @@
+#pragma once
+
+#include "armor_detector/detector.hpp"
+
+namespace rm_auto_aim {
+
+// 默认检测参数
+inline DetectorParams createDefaultParams() {
+    return DetectorParams();
+}
+
+} // namespace rm_auto_aim
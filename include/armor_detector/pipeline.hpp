@@ -0,0 +1,222 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "armor_detector/ballistic_solver.hpp"
+#include "armor_detector/coordinate_transformer.hpp"
+#include "armor_detector/detector.hpp"
+#include "armor_detector/frame_arena.hpp"
+#include "armor_detector/imu_pose_buffer.hpp"
+#include "armor_detector/latency_compensator.hpp"
+#include "armor_detector/multi_tracker.hpp"
+#include "armor_detector/pnp_solver.hpp"
+#include "armor_detector/robot_ekf.hpp"
+#include "armor_detector/spin_observer.hpp"
+#include "armor_detector/spsc_queue.hpp"
+
+namespace rm_auto_aim {
+
+struct PipelineConfig {
+    std::size_t queue_capacity = 2;   // 每个阶段间队列的容量
+    bool drop_oldest = true;          // 下游过慢时丢弃最旧的帧；关闭则上游阻塞等待
+    double stats_interval_s = 1.0;    // 统计输出间隔（秒），<=0 不输出
+    std::ostream* stats_out = &std::cout;  // 统计输出流（无界面模式结果写 stdout 时改为 stderr）
+    double actuation_delay_s = 0.0;   // 输出之后到弹丸出膛的额外延迟（串口传输、云台响应），秒
+    double latency_smoothing = 0.1;   // 实测延迟的指数平滑系数
+    double bullet_speed = 25.0;       // 弹丸初速（m/s），用于弹道解算
+    double fire_half_angle = 0.35;    // 小陀螺时允许射击的装甲板偏离正对方向的最大角度（弧度）
+    double max_reprojection_error = 4.0;  // 位姿在原始图像上的重投影误差 RMS 超过该值（像素）时不使用
+};
+
+// 跟踪/PnP 阶段的结果
+struct TrackResult {
+    Tracker::State state = Tracker::LOST;   // 打击目标所在轨迹的状态
+    bool has_target = false;
+    std::uint32_t target_id = 0;     // 打击目标的轨迹编号，0 表示无目标
+    int track_count = 0;             // 当前全部轨迹数（含未确认的）
+    cv::Point2f predicted_position;
+    bool pnp_valid = false;
+    cv::Vec3d rvec;
+    cv::Vec3d tvec;                  // 相机坐标系，单位：米
+    double reprojection_error = 0.0; // PnP 位姿在原始（带畸变）图像上的重投影误差 RMS（像素）
+    // 设置了 IMU 时：帧时间戳处插值得到的相机光学系 -> 世界系变换，以及世界系下的目标位姿
+    bool imu_valid = false;
+    RigidTransform camera_to_world;
+    cv::Vec3d world_rvec;
+    cv::Vec3d world_tvec;            // 世界系，单位：米
+    // 目标所在车辆的整车估计（世界系 x 前 / y 左 / z 上，需要 PnP；没有 IMU 时世界系与相机固连）
+    bool robot_valid = false;
+    cv::Vec3d robot_center;
+    double robot_yaw = 0.0;
+    double robot_v_yaw = 0.0;        // 弧度/秒，小陀螺时显著非零
+    double robot_radius = 0.0;
+    // 延迟补偿后的瞄准点：按实测端到端延迟 + 执行延迟外推到执行时刻
+    double lead_time_s = 0.0;
+    cv::Point2f aim_position;        // 图像平面（像素）
+    bool aim_valid = false;          // aim_point 需要整车估计
+    cv::Vec3d aim_point;             // 世界系，最正对相机的装甲板（米），已计入弹丸飞行时间
+    BallisticSolution shot;          // 打击 aim_point 的云台 pitch/yaw 与飞行时间（有 IMU 时为世界系绝对角度）
+    // 小陀螺：瞄准点固定在车体正对相机的位置，只在窗口内射击
+    bool spinning = false;
+    double spin_rate = 0.0;          // 由装甲板交接估计的角速度（弧度/秒）
+    FireWindow fire_window;          // 以帧时间戳为基准的下一个射击窗口
+    bool fire_allowed = false;       // 本帧可以射击：有解且（未自旋或处于窗口内）
+};
+
+// 在各阶段间流转的池化帧
+struct PipelineFrame {
+    using Clock = std::chrono::steady_clock;
+
+    std::uint64_t id = 0;
+    cv::Mat image;                   // 采集缓冲，尺寸不变时跨帧复用
+    Clock::time_point capture_time;
+    double timestamp = -1.0;         // 采集时间（秒），用于滤波器的实际帧间隔
+    FrameHandle detections;
+    TrackResult track;
+};
+
+// 采集 -> 检测 -> 跟踪/PnP -> 输出 四级流水线。
+// 采集、检测、跟踪各占一个线程，输出阶段在调用 runOutput() 的线程上运行
+// （HighGUI 通常要求在主线程调用 imshow/waitKey）。
+// 阶段间为有界 SPSC 无锁队列，传递的是帧池中的指针，不复制图像。
+class Pipeline {
+public:
+    enum Stage { CAPTURE = 0, DETECT, TRACK, OUTPUT, STAGE_COUNT };
+
+    struct StageStats {
+        std::uint64_t processed = 0;
+        std::uint64_t dropped = 0;       // 因下游队列满而在本阶段之后丢弃的帧
+        double throughput_fps = 0.0;
+        double mean_latency_ms = 0.0;    // 从采集到本阶段完成
+        double max_latency_ms = 0.0;
+    };
+
+    // 读取下一帧，返回 false 表示输入结束。frame 为复用的缓冲，可直接写入；
+    // timestamp 预置为读帧前的单调时钟（秒），数据源有自己的时间戳（如视频文件）时可覆盖
+    using FrameSource = std::function<bool(cv::Mat& frame, double& timestamp)>;
+    // 处理一帧结果，返回 false 表示请求停止
+    using FrameSink = std::function<bool(const PipelineFrame& frame)>;
+
+    Pipeline(const DetectorParams& params, const PipelineConfig& config = PipelineConfig());
+    ~Pipeline();
+
+    Pipeline(const Pipeline&) = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+
+    // 设置后跟踪阶段对目标做 PnP 解算
+    void setCameraParams(const cv::Mat& camera_matrix, const cv::Mat& dist_coeffs);
+    // 设置后跟踪阶段按帧时间戳查询云台姿态，把 PnP 结果变换到世界系再送入整车 EKF。
+    // buffer 由 IMU 线程写入，流水线只读；须在 start() 之前设置且在流水线停止前保持有效
+    void setImuBuffer(const ImuPoseBuffer* buffer, const CameraMount& mount = CameraMount());
+
+    // 启动采集、检测、跟踪线程
+    bool start(FrameSource source);
+    // 在当前线程运行输出阶段，直到输入结束或 sink 返回 false
+    void runOutput(FrameSink sink);
+    void stop();
+    bool isRunning() const { return running_.load(std::memory_order_acquire); }
+
+    std::array<StageStats, STAGE_COUNT> getStats() const;
+    // 采集到输出的端到端延迟及当前的补偿量
+    LatencyStats getLatencyStats() const { return latency_.getStats(); }
+    void setActuationDelay(double delay_s) { latency_.setActuationDelay(delay_s); }
+    void printStats(std::ostream& os) const;
+    void printStats() const { printStats(*config_.stats_out); }
+
+private:
+    using Queue = SpscQueue<PipelineFrame*>;
+    using Clock = PipelineFrame::Clock;
+
+    struct StageCounters {
+        std::atomic<std::uint64_t> processed{0};
+        std::atomic<std::uint64_t> dropped{0};
+        std::atomic<std::uint64_t> latency_sum_ns{0};
+        std::atomic<std::uint64_t> latency_max_ns{0};
+    };
+
+    void captureLoop();
+    void detectLoop();
+    void trackLoop();
+    // 把所有带位姿的轨迹的装甲板顶点按位姿投影回原始图像（含畸变，一次批量投影），
+    // 与检测到的顶点比较，结果写入 reprojection_errors_（无位姿的轨迹为 -1）
+    void checkReprojection();
+    // 第 index 条轨迹的位姿通过重投影校验
+    bool poseUsable(std::size_t index) const {
+        return reprojection_errors_[index] >= 0.0 && reprojection_errors_[index] <= config_.max_reprojection_error;
+    }
+    // 相机系位姿 -> 整车 EKF 观测；设置了 IMU 但本帧查不到姿态时返回 false
+    bool observe(const cv::Vec3d& rvec, const cv::Vec3d& tvec, const TrackResult& result, ArmorObservation& obs) const;
+    // 用目标及同一车辆上其他可见装甲板的 PnP 结果更新整车 EKF
+    void updateRobot(const PipelineFrame& frame, const Track& target, TrackResult& result);
+
+    // 向下游推送；队列满时按策略丢弃最旧帧或等待
+    void push(Queue& queue, PipelineFrame* frame, Stage stage);
+    // 从上游取帧；上游结束且队列为空时返回 nullptr
+    PipelineFrame* pop(Queue& queue, const std::atomic<bool>& upstream_done);
+    void record(Stage stage, const PipelineFrame& frame);
+
+    PipelineFrame* acquireFrame();
+    void recycleFrame(PipelineFrame* frame);
+
+    void setSearchRoi(const cv::Rect& roi);
+    cv::Rect getSearchRoi() const;
+
+    PipelineConfig config_;
+    // 检测器持有结果帧池，须在流水线帧之后析构
+    Detector detector_;
+    MultiTracker tracker_;
+    PnPSolver pnp_solver_;
+    bool pnp_enabled_ = false;
+    // 重投影校验：与 pnp_solver_ 使用同一组相机参数
+    CoordinateTransformer transformer_;
+    std::vector<cv::Point3f> reprojection_points_;   // 每帧复用的工作区，每条轨迹 4 个顶点
+    std::vector<cv::Point2f> reprojection_pixels_;
+    std::vector<double> reprojection_errors_;         // 下标与 tracker_.getTracks() 相同
+    const ImuPoseBuffer* imu_buffer_ = nullptr;
+    CameraMount camera_mount_;
+    RobotEkf robot_ekf_;
+    std::uint32_t robot_target_id_ = 0;
+    // 装甲板中心到车体中心的距离小于该值时认为属于同一车辆（米）
+    static constexpr double robot_gate_ = 0.6;
+    // 输出阶段写入实测延迟，跟踪阶段读取提前量
+    LatencyCompensator latency_;
+    BallisticSolver ballistic_;
+    SpinObserver spin_observer_;
+    // 飞行时间与命中点相互依赖，交替外推与解算的次数
+    static constexpr int ballistic_iterations_ = 2;
+
+    FrameSource source_;
+    Queue capture_queue_;
+    Queue detect_queue_;
+    Queue track_queue_;
+
+    // 帧池：容量足以覆盖所有队列与各阶段在处理中的帧
+    std::vector<std::unique_ptr<PipelineFrame>> frames_;
+    std::mutex pool_mutex_;
+    std::vector<PipelineFrame*> free_frames_;
+
+    // 跟踪阶段回传给检测阶段的搜索窗口（x, y, w, h 各 16 位打包）
+    std::atomic<std::uint64_t> search_roi_{0};
+
+    std::atomic<bool> running_{false};
+    std::atomic<bool> capture_done_{false};
+    std::atomic<bool> detect_done_{false};
+    std::atomic<bool> track_done_{false};
+    std::array<StageCounters, STAGE_COUNT> counters_;
+    Clock::time_point start_time_;
+
+    std::thread capture_thread_;
+    std::thread detect_thread_;
+    std::thread track_thread_;
+};
+
+} // namespace rm_auto_aim
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <iostream>
+#include <vector>
+#include "armor_detector/camera_model.hpp"
+
+namespace rm_auto_aim {
+
+struct Armor;
+
+// 单块装甲板的位姿（相机坐标系，单位：米）
+struct PnPResult {
+    bool valid = false;
+    cv::Vec3d rvec;
+    cv::Vec3d tvec;
+    double reprojection_error = 0.0;   // 四个顶点的重投影误差 RMS（像素）
+};
+
+class PnPSolver {
+public:
+    PnPSolver();
+    
+    void setCameraParams(const cv::Mat& camera_matrix, const cv::Mat& dist_coeffs);
+    
+    // 由装甲板四个顶点解算位姿（相机坐标系，单位：米）。
+    // 通用路径：cv::solvePnP(SOLVEPNP_IPPE)，作为 solvePlanar 的参考实现
+    bool solvePnP(const Armor& armor, cv::Mat& rvec, cv::Mat& tvec);
+    
+    // 装甲板专用的闭式平面 PnP（IPPE）：四个顶点去畸变后求平面单应，
+    // 在板中心处分解单应的雅可比得到两组候选旋转，取重投影误差较小的一组。
+    // 全部在栈上计算，不分配内存
+    bool solvePlanar(const Armor& armor, PnPResult& result) const;
+    // 一次解算一帧内的所有装甲板（各自的四个顶点），results[i] 对应 armors[i]（results 按需扩容后复用），返回成功的个数
+    int solveBatch(const std::vector<Armor>& armors, std::vector<PnPResult>& results) const;
+    // 以 pose 为初值，对四个顶点的重投影误差做 iterations 步 LM 迭代，结果写回 pose
+    bool refinePlanar(const Armor& armor, PnPResult& pose, int iterations = 3) const;
+    // 跟踪模式：pose / last_pose 为该轨迹上一帧、上上一帧的位姿，解算后依次后移。
+    // 正对相机时两组 IPPE 解的重投影误差相差无几，单帧只能按噪声二选一（偏航角来回翻转）；
+    // 这里在两组解都能解释观测时取与按前两帧匀速外推的姿态更接近的一组，再做 LM 迭代。
+    // 新轨迹（pose 无效）等同于 solvePlanar
+    bool solveTracked(const Armor& armor, PnPResult& pose, PnPResult& last_pose) const;
+    
+    float calculateDistanceToCenter(const cv::Point2f& image_point);
+    
+    // 装甲板模型系下的四个顶点（米），顺序与 Armor::vertices 相同
+    const std::vector<cv::Point3f>& getObjectPoints(const Armor& armor) const;
+    
+    // 装甲板尺寸（单位：米）
+    static constexpr float SMALL_ARMOR_WIDTH = 0.135f;
+    static constexpr float SMALL_ARMOR_HEIGHT = 0.055f;
+    static constexpr float LARGE_ARMOR_WIDTH = 0.225f;
+    static constexpr float LARGE_ARMOR_HEIGHT = 0.055f;
+    
+private:
+    void initWorldPoints();
+    
+    // reference 非空时为参考旋转（模型系到相机系，行优先），用于在两组解之间取舍
+    bool solvePlanar(const Armor& armor, PnPResult& result, const double* reference) const;
+    // rotation 为模型系到相机系的 3x3 旋转（行优先）
+    double reprojectionError(const Armor& armor, const double* rotation, const cv::Vec3d& tvec) const;
+    
+    cv::Mat camera_matrix_;
+    cv::Mat dist_coeffs_;
+    CameraModel model_;                // 与 camera_matrix_ / dist_coeffs_ 同步，逐点去畸变四个顶点
+    // 跟踪模式下 IPPE 解之后的 LM 迭代次数
+    int warm_iterations_ = 1;
+    // 另一组解的误差不超过 ratio * 最优误差 + (每点 pixels 像素) 时视为本帧无法区分
+    double ambiguity_ratio_ = 2.0;
+    double ambiguity_pixels_ = 0.5;
+    std::vector<cv::Point3f> small_armor_points_;
+    std::vector<cv::Point3f> large_armor_points_;
+};
+
+} // namespace rm_auto_aim
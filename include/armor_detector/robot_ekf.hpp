@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <opencv2/opencv.hpp>
+#include "armor_detector/fixed_kalman_filter.hpp"
+
+namespace rm_auto_aim
+{
+// 单块装甲板的三维观测（世界坐标系：x 向前，y 向左，z 向上，单位：米）
+struct ArmorObservation
+{
+  cv::Point3f position;
+  // 装甲板外法向（PnP 模型的 x 轴，由车体中心指向外侧）在水平面内的朝向（弧度）
+  float yaw = 0.0f;
+};
+
+// 整车运动估计的扩展卡尔曼滤波器，用于跟踪小陀螺（底盘自旋）的机器人。
+//
+// 状态 (9)：车体中心 xc, vxc, yc, vyc, 装甲板高度 za, vza, 朝向 yaw, 角速度 v_yaw, 半径 r。
+// 四块装甲板位于 yaw + k*pi/2（k = 0..3），观测 (4)：装甲板中心 xa, ya, za 与朝向 yaw_a，
+//   xa = xc + r*cos(yaw_k)，ya = yc + r*sin(yaw_k)，yaw_a = yaw_k。
+// 每块可见装甲板按朝向最接近的 k 分配后依次校正，装甲板的出现、滑动和消失
+// 都对应同一组车体状态，因此能连续跟踪自旋的目标。
+//
+// 基于 FixedKalmanFilter<9, 4>：预测为线性（匀速 + 匀角速），校正时用当前状态处的
+// 雅可比作为 H，并把观测换算成 z - h(x) + H x，从而复用线性滤波的 correct()。
+// 全部为定长矩阵，不分配内存。
+class RobotEkf
+{
+public:
+  static constexpr int kArmorCount = 4;
+
+  RobotEkf();
+
+  // 用第一块装甲板初始化；timestamp 为采集时间（秒）
+  void init(const ArmorObservation& armor, double timestamp);
+  void reset() { initialized_ = false; }
+
+  // 按与上一时刻的实际间隔预测到 timestamp
+  void predict(double timestamp);
+  // 用一块装甲板校正，返回其被分配到的装甲板序号 k（0..3），未初始化时返回 -1
+  int update(const ArmorObservation& armor);
+
+  // 外推到时刻 t 的四块装甲板位置与朝向，不改变滤波器状态
+  std::array<ArmorObservation, kArmorCount> predictArmors(double timestamp) const;
+  // 四块装甲板中最正对观测点（世界系原点）的一块，返回其序号
+  static int facingArmor(const std::array<ArmorObservation, kArmorCount>& armors);
+
+  bool isInitialized() const { return initialized_; }
+  double getTimestamp() const { return last_timestamp_; }
+  cv::Point3f getCenter() const;
+  cv::Point3f getVelocity() const;
+  float getYaw() const { return kf_.statePost[6]; }
+  float getYawRate() const { return kf_.statePost[7]; }
+  float getRadius() const { return kf_.statePost[8]; }
+
+  // 由 PnPSolver::solvePnP 的 rvec/tvec（相机光学坐标系：x 右，y 下，z 前）构造观测。
+  // 没有云台姿态时世界系即与相机固连的 x 前 / y 左 / z 上 坐标系
+  static ArmorObservation observationFromPnP(const cv::Vec3d& rvec, const cv::Vec3d& tvec);
+  // 由已变换到世界系（x 前 / y 左 / z 上）的装甲板位姿构造观测，用于接入云台姿态之后
+  static ArmorObservation observationFromWorld(const cv::Vec3d& rvec, const cv::Vec3d& tvec);
+
+  // 把角度 a 换算到与 reference 相差不超过 pi 的等价值
+  static float unwrapAngle(float a, float reference);
+
+private:
+  using Filter = FixedKalmanFilter<9, 4>;
+
+  void setTransition(float dt);
+  // 朝向与 yaw_a 最接近的装甲板序号
+  int assignArmor(float yaw_a) const;
+
+  Filter kf_;
+  bool initialized_ = false;
+  double last_timestamp_ = -1.0;
+
+  // 过程噪声为分段白噪声加速度模型（方差，单位分别为 m^2/s^4、rad^2/s^4、m^2）
+  static constexpr float sigma2QXyz_ = 20.0f;
+  static constexpr float sigma2QYaw_ = 100.0f;
+  static constexpr float sigma2QR_ = 800.0f;
+  // 观测噪声：位置方差与距离成正比，朝向方差为常数
+  static constexpr float rXyzFactor_ = 4e-4f;
+  static constexpr float rYaw_ = 5e-3f;
+
+  static constexpr float initialRadius_ = 0.26f;
+  static constexpr float minRadius_ = 0.12f;
+  static constexpr float maxRadius_ = 0.4f;
+  static constexpr float minDt_ = 1e-4f;
+  static constexpr float maxDt_ = 0.5f;
+};
+
+}  // namespace rm_auto_aim
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <opencv2/opencv.hpp>
+#include "armor_detector/robot_ekf.hpp"
+
+namespace rm_auto_aim {
+
+// 火控窗口：在 [open_time, close_time] 内发出的射击指令，命中时恰有装甲板正对相机。
+// 时间基准与帧时间戳相同（秒）
+struct FireWindow {
+    bool valid = false;
+    double open_time = 0.0;
+    double close_time = 0.0;
+
+    bool contains(double t) const { return valid && t >= open_time && t <= close_time; }
+};
+
+// 小陀螺观测器：统计同一车辆上装甲板的周期性交接，估计自旋角速度，
+// 并预测下一块装甲板正对相机的时刻，给出射击窗口，而不是逐块追瞄。
+//
+// 同一车辆上出现编号更大的轨迹即视为一次交接（新装甲板转入视野），
+// 四块装甲板每转过 pi/2 交接一次，|角速度| = (pi/2) / 交接间隔，方向取整车 EKF 的角速度符号。
+// 交接间隔做指数平滑；过短的（同一装甲板轨迹重建）忽略，漏检一次的按整数倍折算。
+// 每帧 update 为常数开销。
+class SpinObserver {
+public:
+    // fire_half_angle 为允许射击的装甲板偏离正对方向的最大角度（弧度）
+    explicit SpinObserver(double fire_half_angle = 0.35);
+
+    void reset();
+    // 每帧调用一次：newest_plate_id 为本帧该车辆上匹配到的装甲板中最大的轨迹编号（没有时为 0），
+    // yaw_rate 为整车 EKF 的角速度（弧度/秒）
+    void update(double timestamp, std::uint32_t newest_plate_id, double yaw_rate);
+
+    // 已观测到连续交接且最近一次交接仍在预期周期内
+    bool isSpinning() const;
+    double getSpinRate() const { return spin_rate_; }          // 弧度/秒，带方向
+    double getHandoffInterval() const { return interval_; }    // 秒
+    int getHandoffCount() const { return handoff_count_; }
+
+    // 从 timestamp 起、指令延迟 delay（执行延迟 + 飞行时间）下的下一个射击窗口；未在自旋时无效
+    FireWindow nextFireWindow(const RobotEkf& robot, double timestamp, double delay) const;
+
+    // 时刻 t 车体上正对相机（世界系原点）方向的装甲板位置，自旋时作为固定瞄准点
+    static cv::Point3f facingPoint(const RobotEkf& robot, double timestamp);
+
+private:
+    double fire_half_angle_;
+
+    std::uint32_t newest_id_ = 0;
+    double last_handoff_ = -1.0;
+    double last_update_ = -1.0;
+    double interval_ = 0.0;
+    int handoff_count_ = 0;
+    double spin_rate_ = 0.0;
+
+    static constexpr double smoothing_ = 0.3;
+    static constexpr double min_interval_ = 0.05;   // 更短的视为轨迹抖动
+    static constexpr double max_interval_ = 1.5;    // 更长的视为没有持续自旋（约 1 rad/s）
+    static constexpr int min_handoffs_ = 4;         // 至少两个完整的交接间隔才认为在自旋
+};
+
+} // namespace rm_auto_aim
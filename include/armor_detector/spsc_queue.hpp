@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+namespace rm_auto_aim {
+
+// 有界单生产者/单消费者无锁队列。
+// 元素须为可平凡复制的小类型（通常是指向池化帧的指针），槽位以原子量存放；
+// 队列满时生产者可以调用 dropOldest() 丢弃最旧的元素，与消费者通过 CAS 竞争队头，
+// 因此“丢最旧”策略下仍然无锁。索引单调递增，不存在 ABA 问题。
+template <typename T>
+class SpscQueue {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "SpscQueue only carries trivially copyable items");
+
+public:
+    explicit SpscQueue(std::size_t capacity)
+        : capacity_(capacity > 0 ? capacity : 1),
+          slots_(new std::atomic<T>[capacity_]) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // 生产者：队列满时返回 false
+    bool tryPush(const T& item) {
+        const std::uint64_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) >= capacity_) {
+            return false;
+        }
+        slots_[tail % capacity_].store(item, std::memory_order_relaxed);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 消费者：队列空时返回 false
+    bool tryPop(T& item) {
+        return claimHead(item);
+    }
+
+    // 生产者：取出最旧的元素以腾出空间（与消费者竞争，谁先拿到归谁）
+    bool dropOldest(T& item) {
+        return claimHead(item);
+    }
+
+    std::size_t size() const {
+        const std::uint64_t head = head_.load(std::memory_order_acquire);
+        const std::uint64_t tail = tail_.load(std::memory_order_acquire);
+        return static_cast<std::size_t>(tail - head);
+    }
+
+    bool empty() const { return size() == 0; }
+    std::size_t capacity() const { return capacity_; }
+
+private:
+    bool claimHead(T& item) {
+        std::uint64_t head = head_.load(std::memory_order_acquire);
+        while (true) {
+            if (head == tail_.load(std::memory_order_acquire)) {
+                return false;
+            }
+            // 先读槽位再 CAS：CAS 成功说明读取期间队头未移动，
+            // 生产者不会覆盖队头所在的槽位，读到的值有效
+            T value = slots_[head % capacity_].load(std::memory_order_relaxed);
+            if (head_.compare_exchange_weak(head, head + 1,
+                                            std::memory_order_acq_rel,
+                                            std::memory_order_acquire)) {
+                item = value;
+                return true;
+            }
+        }
+    }
+
+    const std::size_t capacity_;
+    std::unique_ptr<std::atomic<T>[]> slots_;
+
+    // 队头、队尾分处不同缓存行，避免生产者与消费者伪共享
+    alignas(64) std::atomic<std::uint64_t> head_{0};
+    alignas(64) std::atomic<std::uint64_t> tail_{0};
+};
+
+} // namespace rm_auto_aim
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "armor_detector/armor.hpp"
+#include "armor_detector/motion_filter.hpp"
+
+namespace rm_auto_aim {
+
+// 马氏距离门限：预测后按新息协方差 S 计算一次逆矩阵，之后每个候选只需一次二次型
+struct InnovationGate {
+    float inv_s00 = 0.0f;
+    float inv_s01 = 0.0f;
+    float inv_s11 = 0.0f;
+
+    // S 为对称 2x2 矩阵 [s00 s01; s01 s11]；奇异时返回 false
+    bool set(float s00, float s01, float s11);
+    // 新息 d 的马氏距离平方 d^T S^-1 d
+    float distance2(const cv::Point2f& d) const {
+        return inv_s00 * d.x * d.x + 2.0f * inv_s01 * d.x * d.y + inv_s11 * d.y * d.y;
+    }
+};
+
+class Tracker {
+public:
+    enum State { LOST, DETECTING, TRACKING, TEMP_LOST };
+    // 运动滤波器：单一匀速模型卡尔曼滤波，或匀速/匀加速/静止三模型 IMM
+    enum FilterType { KALMAN_FILTER, IMM_FILTER };
+    
+    explicit Tracker(FilterType filter_type = KALMAN_FILTER);
+    
+    // timestamp 为帧的采集时间（秒）；<0 时按上一帧时间加标称帧间隔推算
+    void init(const Armor& armor, double timestamp = -1.0);
+    void update(const std::vector<Armor>& armors, double timestamp = -1.0);
+    void reset();
+    
+    // 外推目标在时刻 t（秒）的图像位置，不改变跟踪状态；未跟踪时返回最近的预测位置
+    cv::Point2f predictAt(double timestamp) const;
+    
+    // 供 Detector::detect(frame, roi_hint) 使用的搜索窗口；
+    // 仅在 TRACKING / TEMP_LOST 状态返回非空窗口
+    cv::Rect getSearchRoi(const cv::Size& image_size) const;
+    
+    State getState() const { return state_; }
+    // 连续匹配多少帧后由 DETECTING 转为 TRACKING
+    int getTrackingThreshold() const { return tracking_thres_; }
+    bool isTracking() const { return is_tracking_; }
+    cv::Point2f getPredictedPosition() const { return predicted_position_; }
+    const Armor* getTrackedArmor() const { return has_tracked_armor_ ? &tracked_armor_ : nullptr; }
+    
+    // 匹配代价：候选中心相对预测位置的马氏距离平方，按与已跟踪装甲板的尺寸差异加权（越小越好）；
+    // 超出门限时返回负值，此时不计算尺寸差异
+    static float matchScore(const Armor& tracked, const cv::Point2f& predicted,
+                            const InnovationGate& gate, float gate_chi2, const Armor& armor);
+    // 两块装甲板边长之比的较大者（>=1），按顶点间边长计算，不受装甲板倾斜影响
+    static float sizePenalty(const Armor& tracked, const Armor& armor);
+    
+    // 卡方门限（2 自由度，默认 99%）与门限中计入的未建模运动标准差（像素）
+    static constexpr float default_gate_chi2_ = 9.21f;
+    static constexpr float default_gate_motion_std_ = 15.0f;
+    
+private:
+    const Armor* selectBestMatch(const std::vector<Armor>& armors);
+    // 由当前滤波器协方差计算本帧的门限
+    void updateGate();
+    
+    std::unique_ptr<MotionFilter> kf_;
+    
+    State state_ = LOST;
+    bool is_tracking_ = false;
+    // 按值保存，不引用调用方的装甲板数组
+    Armor tracked_armor_;
+    bool has_tracked_armor_ = false;
+    cv::Rect last_armor_rect_;
+    cv::Point2f predicted_position_;
+    
+    int detect_count_ = 0;
+    int lost_count_ = 0;
+    int tracking_thres_ = 5;
+    int lost_thres_ = 5;
+    InnovationGate gate_;
+    float gate_chi2_ = default_gate_chi2_;
+    float gate_motion_std_ = default_gate_motion_std_;
+    float roi_scale_ = 1.0f;  // 搜索窗口四周各扩展的装甲板尺寸倍数
+    double last_timestamp_ = -1.0;
+    static constexpr double nominal_frame_interval_ = 0.033;
+};
+
+} // namespace rm_auto_aim
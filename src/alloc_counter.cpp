@@ -0,0 +1,84 @@
+#include "armor_detector/alloc_counter.hpp"
+
+#if defined(RM_COUNT_ALLOCATIONS) && defined(__GLIBC__)
+
+#include <atomic>
+#include <cerrno>
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t n, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+}
+
+namespace {
+std::atomic<std::size_t> g_allocations{0};
+// 常量初始化的线程局部变量，initial-exec 模型下访问不会反过来调用 malloc
+__attribute__((tls_model("initial-exec"))) thread_local std::size_t t_allocations = 0;
+
+inline void countAllocation() {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    ++t_allocations;
+}
+} // namespace
+
+// 覆盖 glibc 的分配入口，free 不需要计数
+extern "C" {
+
+void* malloc(size_t size) noexcept {
+    countAllocation();
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t n, size_t size) noexcept {
+    countAllocation();
+    return __libc_calloc(n, size);
+}
+
+void* realloc(void* ptr, size_t size) noexcept {
+    countAllocation();
+    return __libc_realloc(ptr, size);
+}
+
+void* memalign(size_t alignment, size_t size) noexcept {
+    countAllocation();
+    return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) noexcept {
+    countAllocation();
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** out, size_t alignment, size_t size) noexcept {
+    countAllocation();
+    *out = __libc_memalign(alignment, size);
+    return *out ? 0 : ENOMEM;
+}
+
+} // extern "C"
+
+namespace rm_auto_aim {
+namespace alloc_counter {
+
+bool enabled() { return true; }
+std::size_t count() { return t_allocations; }
+std::size_t totalCount() { return g_allocations.load(std::memory_order_relaxed); }
+
+} // namespace alloc_counter
+} // namespace rm_auto_aim
+
+#else
+
+namespace rm_auto_aim {
+namespace alloc_counter {
+
+bool enabled() { return false; }
+std::size_t count() { return 0; }
+std::size_t totalCount() { return 0; }
+
+} // namespace alloc_counter
+} // namespace rm_auto_aim
+
+#endif
@@ -4,28 +4,25 @@
 
 namespace rm_auto_aim {
 
-// 构造函数 - 需要修正为使用指针
-Armor::Armor(const Light& left_light, const Light& right_light) 
-    : left_light(&left_light), right_light(&right_light) {
+// 构造函数 - 灯条以下标引用，装甲板本身不持有指针
+Armor::Armor(const Light& left_light, const Light& right_light,
+             int left_index, int right_index) 
+    : left_light(left_index), right_light(right_index) {
     // 计算中心点
     center = (left_light.center + right_light.center) * 0.5f;
     // 更新顶点
-    updateVertices();
+    updateVertices(left_light, right_light);
 }
 
 // 更新顶点
-void Armor::updateVertices() {
-    vertices.clear();
-    
-    if (!left_light || !right_light) return;
-    
+void Armor::updateVertices(const Light& left, const Light& right) {
     // 左灯条的顶部和底部
-    cv::Point2f left_top = left_light->top;
-    cv::Point2f left_bottom = left_light->bottom;
+    cv::Point2f left_top = left.top;
+    cv::Point2f left_bottom = left.bottom;
     
     // 右灯条的顶部和底部
-    cv::Point2f right_top = right_light->top;
-    cv::Point2f right_bottom = right_light->bottom;
+    cv::Point2f right_top = right.top;
+    cv::Point2f right_bottom = right.bottom;
     
     // 确保顶点顺序：左上 -> 右上 -> 右下 -> 左下
     // 通过y坐标确定上下
@@ -40,18 +37,22 @@ void Armor::updateVertices() {
     if (left_top.x > right_top.x) {
         std::swap(left_top, right_top);
         std::swap(left_bottom, right_bottom);
+        std::swap(left_light, right_light);
     }
     
-    // 添加顶点
-    vertices.push_back(left_top);
-    vertices.push_back(right_top);
-    vertices.push_back(right_bottom);
-    vertices.push_back(left_bottom);
+    // 写入顶点
+    vertices[0] = left_top;
+    vertices[1] = right_top;
+    vertices[2] = right_bottom;
+    vertices[3] = left_bottom;
+    
+    // 固定数组包装成 Mat，不分配内存
+    boundingRect = cv::boundingRect(cv::Mat(4, 1, CV_32FC2, vertices.data()));
 }
 
 // 绘制装甲板 - 确保这里有 const !!!
 void Armor::draw(cv::Mat& img, const cv::Scalar& color, int thickness) const {
-    if (vertices.size() == 4) {
+    if (isValid()) {
         // 绘制四边形
         for (size_t i = 0; i < 4; ++i) {
             cv::line(img, vertices[i], vertices[(i + 1) % 4], color, thickness);
@@ -75,9 +76,4 @@ void Armor::draw(cv::Mat& img, const cv::Scalar& color, int thickness) const {
     }
 }
 
-// 计算顶点（内部使用）
-void Armor::calculateVertices() {
-    // 这个函数已经被updateVertices()替代
-}
-
 } // namespace rm_auto_aim
\ No newline at end of file
@@ -0,0 +1,91 @@
+#include <limits>
+#include "armor_detector/assignment.hpp"
+
+namespace rm_auto_aim {
+
+double AssignmentSolver::solve(const float* cost, int rows, int cols, std::vector<int>& row_to_col) {
+    row_to_col.assign(rows > 0 ? rows : 0, -1);
+    if (rows <= 0 || cols <= 0) {
+        return 0.0;
+    }
+
+    // 算法要求行数不超过列数，否则在转置后的矩阵上求解
+    if (rows <= cols) {
+        return solveWide(cost, rows, cols, false, row_to_col);
+    }
+    return solveWide(cost, cols, rows, true, row_to_col);
+}
+
+double AssignmentSolver::solveWide(const float* cost, int n, int m, bool transposed,
+                                   std::vector<int>& row_to_col) {
+    const double kInf = std::numeric_limits<double>::infinity();
+    // 转置时第 i 行第 j 列取原矩阵的 (j, i)
+    auto at = [cost, n, m, transposed](int i, int j) -> double {
+        return transposed ? cost[j * n + i] : cost[i * m + j];
+    };
+
+    // 下标从 1 开始，第 0 列为虚拟列
+    u_.assign(n + 1, 0.0);
+    v_.assign(m + 1, 0.0);
+    p_.assign(m + 1, 0);
+    way_.assign(m + 1, 0);
+
+    for (int i = 1; i <= n; ++i) {
+        p_[0] = i;
+        int j0 = 0;
+        minv_.assign(m + 1, kInf);
+        used_.assign(m + 1, 0);
+
+        // 从第 i 行出发沿最短增广路扩展，直到到达一个空闲列
+        do {
+            used_[j0] = 1;
+            const int i0 = p_[j0];
+            double delta = kInf;
+            int j1 = 0;
+            for (int j = 1; j <= m; ++j) {
+                if (used_[j]) continue;
+                const double cur = at(i0 - 1, j - 1) - u_[i0] - v_[j];
+                if (cur < minv_[j]) {
+                    minv_[j] = cur;
+                    way_[j] = j0;
+                }
+                if (minv_[j] < delta) {
+                    delta = minv_[j];
+                    j1 = j;
+                }
+            }
+            for (int j = 0; j <= m; ++j) {
+                if (used_[j]) {
+                    u_[p_[j]] += delta;
+                    v_[j] -= delta;
+                } else {
+                    minv_[j] -= delta;
+                }
+            }
+            j0 = j1;
+        } while (p_[j0] != 0);
+
+        // 沿路径回溯，翻转匹配
+        do {
+            const int j1 = way_[j0];
+            p_[j0] = p_[j1];
+            j0 = j1;
+        } while (j0 != 0);
+    }
+
+    double total = 0.0;
+    for (int j = 1; j <= m; ++j) {
+        if (p_[j] == 0) continue;
+        const int row = p_[j] - 1;
+        const int col = j - 1;
+        total += at(row, col);
+        if (transposed) {
+            row_to_col[col] = row;
+        } else {
+            row_to_col[row] = col;
+        }
+    }
+    return total;
+}
+
+} // namespace rm_auto_aim
@@ -0,0 +1,277 @@
+#include <cmath>
+#include <limits>
+#include "armor_detector/ballistic_solver.hpp"
+
+namespace rm_auto_aim
+{
+
+namespace
+{
+// 竖直平面内的弹丸状态：水平距离 x、高度 y 及其速度
+struct ProjectileState
+{
+  double x, y, vx, vy;
+};
+
+ProjectileState derivative(const ProjectileState& s, double k, double g)
+{
+  const double v = std::sqrt(s.vx * s.vx + s.vy * s.vy);
+  return {s.vx, s.vy, -k * v * s.vx, -k * v * s.vy - g};
+}
+
+ProjectileState rk4Step(const ProjectileState& s, double dt, double k, double g)
+{
+  auto advance = [](const ProjectileState& s, const ProjectileState& d, double h) {
+    return ProjectileState{s.x + d.x * h, s.y + d.y * h, s.vx + d.vx * h, s.vy + d.vy * h};
+  };
+  const ProjectileState k1 = derivative(s, k, g);
+  const ProjectileState k2 = derivative(advance(s, k1, dt / 2.0), k, g);
+  const ProjectileState k3 = derivative(advance(s, k2, dt / 2.0), k, g);
+  const ProjectileState k4 = derivative(advance(s, k3, dt), k, g);
+  return {s.x + dt / 6.0 * (k1.x + 2.0 * k2.x + 2.0 * k3.x + k4.x),
+          s.y + dt / 6.0 * (k1.y + 2.0 * k2.y + 2.0 * k3.y + k4.y),
+          s.vx + dt / 6.0 * (k1.vx + 2.0 * k2.vx + 2.0 * k3.vx + k4.vx),
+          s.vy + dt / 6.0 * (k1.vy + 2.0 * k2.vy + 2.0 * k3.vy + k4.vy)};
+}
+
+int gridCount(double min, double max, double step)
+{
+  return std::max(2, static_cast<int>(std::floor((max - min) / step + 0.5)) + 1);
+}
+
+// value 所在的网格单元与单元内比例，超出网格范围返回 false
+bool gridIndex(double value, double min, double step, int count, int& index, float& frac)
+{
+  const double f = (value - min) / step;
+  if (!(f >= 0.0 && f <= count - 1)) {
+    return false;
+  }
+  index = std::min(static_cast<int>(f), count - 2);
+  frac = static_cast<float>(f - index);
+  return true;
+}
+
+constexpr float kNaN = std::numeric_limits<float>::quiet_NaN();
+}  // namespace
+
+BallisticSolver::BallisticSolver(const BallisticParams& params)
+: params_(params)
+{
+  speedCount_ = gridCount(params_.min_speed, params_.max_speed, params_.speed_step);
+  pitchCount_ = gridCount(params_.min_pitch, params_.max_pitch, params_.pitch_step);
+  distanceCount_ = gridCount(params_.min_distance, params_.max_distance, params_.distance_step);
+  heightCount_ = gridCount(params_.min_height, params_.max_height, params_.height_step);
+
+  buildForwardTable();
+  buildInverseTable();
+}
+
+void BallisticSolver::buildForwardTable()
+{
+  forward_.assign(static_cast<std::size_t>(speedCount_) * pitchCount_ * distanceCount_, Sample{kNaN, kNaN});
+  const double dt = params_.integration_step;
+
+  for (int iv = 0; iv < speedCount_; ++iv) {
+    const double speed = params_.min_speed + iv * params_.speed_step;
+    for (int ip = 0; ip < pitchCount_; ++ip) {
+      const double pitch = params_.min_pitch + ip * params_.pitch_step;
+      Sample* row = &forward_[(static_cast<std::size_t>(iv) * pitchCount_ + ip) * distanceCount_];
+
+      // 一次积分，沿途依次记录经过每个距离网格的高度与时间
+      ProjectileState s{0.0, 0.0, speed * std::cos(pitch), speed * std::sin(pitch)};
+      double t = 0.0;
+      int id = 0;
+      while (id < distanceCount_ && t < params_.max_flight_time) {
+        const ProjectileState next = rk4Step(s, dt, params_.drag_coeff, params_.gravity);
+        double distance = params_.min_distance + id * params_.distance_step;
+        while (id < distanceCount_ && next.x >= distance) {
+          const double f = (distance - s.x) / (next.x - s.x);
+          row[id].height = static_cast<float>(s.y + f * (next.y - s.y));
+          row[id].time = static_cast<float>(t + f * dt);
+          ++id;
+          distance = params_.min_distance + id * params_.distance_step;
+        }
+        // 已落到表的高度范围以下，后续距离不会再用到
+        if (next.vy < 0.0 && next.y < params_.min_height - 1.0) {
+          break;
+        }
+        s = next;
+        t += dt;
+      }
+    }
+  }
+}
+
+void BallisticSolver::buildInverseTable()
+{
+  inverse_.assign(static_cast<std::size_t>(speedCount_) * distanceCount_ * heightCount_, kNaN);
+
+  for (int iv = 0; iv < speedCount_; ++iv) {
+    for (int id = 0; id < distanceCount_; ++id) {
+      float* row = &inverse_[(static_cast<std::size_t>(iv) * distanceCount_ + id) * heightCount_];
+
+      // 低弹道段高度随 pitch 单调上升，高度升序扫描时 pitch 单元只需前移
+      int ip = 0;
+      for (int ih = 0; ih < heightCount_; ++ih) {
+        const float height = static_cast<float>(params_.min_height + ih * params_.height_step);
+        for (; ip + 1 < pitchCount_; ++ip) {
+          const float a = forward(iv, ip, id).height;
+          const float b = forward(iv, ip + 1, id).height;
+          if (!std::isfinite(a) || !std::isfinite(b)) continue;
+          if (b <= a) break;  // 越过最高点，高弹道解不取
+          if (height <= b) {
+            if (height >= a) {
+              row[ih] = static_cast<float>(params_.min_pitch + (ip + (height - a) / (b - a)) * params_.pitch_step);
+            }
+            break;
+          }
+        }
+      }
+    }
+  }
+}
+
+bool BallisticSolver::lookupForward(double speed, double pitch, double distance,
+                                    float& height, float& dheight, float& time) const
+{
+  int iv, ip, id;
+  float fv, fp, fd;
+  if (!gridIndex(speed, params_.min_speed, params_.speed_step, speedCount_, iv, fv) ||
+      !gridIndex(pitch, params_.min_pitch, params_.pitch_step, pitchCount_, ip, fp) ||
+      !gridIndex(distance, params_.min_distance, params_.distance_step, distanceCount_, id, fd)) {
+    return false;
+  }
+
+  // 两个 pitch 网格面上分别对 (speed, distance) 双线性插值
+  float h[2], t[2];
+  for (int k = 0; k < 2; ++k) {
+    const Sample& s00 = forward(iv, ip + k, id);
+    const Sample& s01 = forward(iv, ip + k, id + 1);
+    const Sample& s10 = forward(iv + 1, ip + k, id);
+    const Sample& s11 = forward(iv + 1, ip + k, id + 1);
+    h[k] = (1.0f - fv) * ((1.0f - fd) * s00.height + fd * s01.height) +
+           fv * ((1.0f - fd) * s10.height + fd * s11.height);
+    t[k] = (1.0f - fv) * ((1.0f - fd) * s00.time + fd * s01.time) +
+           fv * ((1.0f - fd) * s10.time + fd * s11.time);
+  }
+
+  height = h[0] + fp * (h[1] - h[0]);
+  dheight = (h[1] - h[0]) / static_cast<float>(params_.pitch_step);
+  time = t[0] + fp * (t[1] - t[0]);
+  return std::isfinite(height) && std::isfinite(time);
+}
+
+BallisticSolution BallisticSolver::solve(double distance, double height, double speed) const
+{
+  BallisticSolution solution;
+  int iv, id, ih;
+  float fv, fd, fh;
+  if (!gridIndex(speed, params_.min_speed, params_.speed_step, speedCount_, iv, fv) ||
+      !gridIndex(distance, params_.min_distance, params_.distance_step, distanceCount_, id, fd) ||
+      !gridIndex(height, params_.min_height, params_.height_step, heightCount_, ih, fh)) {
+    return solution;
+  }
+
+  // 反向表三线性插值得到初值
+  float pitch = 0.0f;
+  for (int a = 0; a < 2; ++a) {
+    for (int b = 0; b < 2; ++b) {
+      const float w = (a ? fv : 1.0f - fv) * (b ? fd : 1.0f - fd);
+      pitch += w * ((1.0f - fh) * inverse(iv + a, id + b, ih) + fh * inverse(iv + a, id + b, ih + 1));
+    }
+  }
+  if (!std::isfinite(pitch)) {
+    return solution;
+  }
+
+  // 在正向表上做一步牛顿迭代：pitch -= (h(pitch) - height) / h'(pitch)
+  float h, dh, t;
+  if (!lookupForward(speed, pitch, distance, h, dh, t)) {
+    return solution;
+  }
+  if (dh > 0.0f) {
+    const float refined = pitch - (h - static_cast<float>(height)) / dh;
+    if (lookupForward(speed, refined, distance, h, dh, t)) {
+      pitch = refined;
+    }
+  }
+
+  solution.valid = true;
+  solution.pitch = pitch;
+  solution.flight_time = t;
+  return solution;
+}
+
+BallisticSolution BallisticSolver::solve(const cv::Point3f& target, double speed) const
+{
+  const double distance = std::sqrt(static_cast<double>(target.x) * target.x + static_cast<double>(target.y) * target.y);
+  BallisticSolution solution = solve(distance, target.z, speed);
+  solution.yaw = static_cast<float>(std::atan2(target.y, target.x));
+  return solution;
+}
+
+bool BallisticSolver::simulate(const BallisticParams& params, double speed, double pitch, double distance,
+                               double& height, double& time, double dt)
+{
+  ProjectileState s{0.0, 0.0, speed * std::cos(pitch), speed * std::sin(pitch)};
+  double t = 0.0;
+  while (t < params.max_flight_time) {
+    const ProjectileState next = rk4Step(s, dt, params.drag_coeff, params.gravity);
+    if (next.x >= distance) {
+      const double f = (distance - s.x) / (next.x - s.x);
+      height = s.y + f * (next.y - s.y);
+      time = t + f * dt;
+      return true;
+    }
+    s = next;
+    t += dt;
+  }
+  return false;
+}
+
+BallisticSolution BallisticSolver::solveReference(const BallisticParams& params, double distance, double height,
+                                                  double speed, double dt)
+{
+  BallisticSolution solution;
+  constexpr double scan_step = 0.02;
+
+  // 粗扫找到低弹道上包含目标高度的区间，再二分
+  double lo = params.min_pitch, h_lo = 0.0, t_lo = 0.0;
+  if (!simulate(params, speed, lo, distance, h_lo, t_lo, dt) || h_lo > height) {
+    return solution;
+  }
+  double hi = lo;
+  bool bracketed = false;
+  while (hi < params.max_pitch) {
+    double h_hi, t_hi;
+    hi = std::min(lo + scan_step, params.max_pitch);
+    if (!simulate(params, speed, hi, distance, h_hi, t_hi, dt) || h_hi <= h_lo) {
+      return solution;
+    }
+    if (h_hi >= height) {
+      bracketed = true;
+      break;
+    }
+    lo = hi;
+    h_lo = h_hi;
+  }
+  if (!bracketed) {
+    return solution;
+  }
+
+  double h_mid = 0.0, t_mid = 0.0;
+  for (int i = 0; i < 32; ++i) {
+    const double mid = 0.5 * (lo + hi);
+    simulate(params, speed, mid, distance, h_mid, t_mid, dt);
+    (h_mid < height ? lo : hi) = mid;
+  }
+  const double pitch = 0.5 * (lo + hi);
+  simulate(params, speed, pitch, distance, h_mid, t_mid, dt);
+
+  solution.valid = true;
+  solution.pitch = static_cast<float>(pitch);
+  solution.flight_time = static_cast<float>(t_mid);
+  return solution;
+}
+
+}  // namespace rm_auto_aim
@@ -0,0 +1,352 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include "armor_detector/batched_kalman_filter.hpp"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define RM_BATCHED_KF_X86 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define RM_BATCHED_KF_NEON 1
+#endif
+
+namespace rm_auto_aim
+{
+
+namespace
+{
+
+// 单轴分量的裸指针视图，供各实现共用
+struct AxisView
+{
+  float* pos;
+  float* vel;
+  float* p00;
+  float* p01;
+  float* p11;
+  const float* z;
+};
+
+// x' = F x，P' = F P F^T + Q，F = [1 dt; 0 1]
+void predictScalar(const AxisView& a, std::size_t begin, std::size_t end,
+                   float dt, float q_pos, float q_vel)
+{
+  for (std::size_t i = begin; i < end; ++i) {
+    a.pos[i] = a.pos[i] + a.vel[i] * dt;
+    a.p00[i] = a.p00[i] + dt * (2.0f * a.p01[i] + dt * a.p11[i]) + q_pos;
+    a.p01[i] = a.p01[i] + dt * a.p11[i];
+    a.p11[i] = a.p11[i] + q_vel;
+  }
+}
+
+// H = [1 0]：S = P00 + R，K = [P00; P01] / S；mask 为 0 的目标保持不变
+void updateScalar(const AxisView& a, const unsigned char* mask, std::size_t begin,
+                  std::size_t end, float r)
+{
+  for (std::size_t i = begin; i < end; ++i) {
+    if (!mask[i]) continue;
+
+    const float p00 = a.p00[i];
+    const float p01 = a.p01[i];
+    const float s = p00 + r;
+    const float k0 = p00 / s;
+    const float k1 = p01 / s;
+    const float innovation = a.z[i] - a.pos[i];
+
+    a.pos[i] = a.pos[i] + k0 * innovation;
+    a.vel[i] = a.vel[i] + k1 * innovation;
+    a.p00[i] = p00 - k0 * p00;
+    a.p01[i] = p01 - k0 * p01;
+    a.p11[i] = a.p11[i] - k1 * p01;
+  }
+}
+
+#if RM_BATCHED_KF_X86
+
+// 8 个目标一组，返回已处理的数量（剩余部分由标量实现完成）
+__attribute__((target("avx2")))
+std::size_t predictAvx2(const AxisView& a, std::size_t n, float dt, float q_pos, float q_vel)
+{
+  const __m256 vdt = _mm256_set1_ps(dt);
+  const __m256 vtwo = _mm256_set1_ps(2.0f);
+  const __m256 vqp = _mm256_set1_ps(q_pos);
+  const __m256 vqv = _mm256_set1_ps(q_vel);
+
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256 pos = _mm256_loadu_ps(a.pos + i);
+    __m256 vel = _mm256_loadu_ps(a.vel + i);
+    __m256 p00 = _mm256_loadu_ps(a.p00 + i);
+    __m256 p01 = _mm256_loadu_ps(a.p01 + i);
+    __m256 p11 = _mm256_loadu_ps(a.p11 + i);
+
+    pos = _mm256_add_ps(pos, _mm256_mul_ps(vel, vdt));
+    __m256 t = _mm256_add_ps(_mm256_mul_ps(vtwo, p01), _mm256_mul_ps(vdt, p11));
+    p00 = _mm256_add_ps(_mm256_add_ps(p00, _mm256_mul_ps(vdt, t)), vqp);
+    p01 = _mm256_add_ps(p01, _mm256_mul_ps(vdt, p11));
+    p11 = _mm256_add_ps(p11, vqv);
+
+    _mm256_storeu_ps(a.pos + i, pos);
+    _mm256_storeu_ps(a.p00 + i, p00);
+    _mm256_storeu_ps(a.p01 + i, p01);
+    _mm256_storeu_ps(a.p11 + i, p11);
+  }
+  return i;
+}
+
+__attribute__((target("avx2")))
+std::size_t updateAvx2(const AxisView& a, const unsigned char* mask, std::size_t n, float r)
+{
+  const __m256 vr = _mm256_set1_ps(r);
+  const __m128i zero = _mm_setzero_si128();
+
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    // 8 字节掩码扩展为 8 个 32 位通道掩码
+    __m128i m8 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(mask + i));
+    m8 = _mm_xor_si128(_mm_cmpeq_epi8(m8, zero), _mm_set1_epi8(-1));
+    const __m256 m = _mm256_castsi256_ps(_mm256_cvtepi8_epi32(m8));
+    if (_mm256_testz_ps(m, m)) continue;
+
+    const __m256 pos = _mm256_loadu_ps(a.pos + i);
+    const __m256 vel = _mm256_loadu_ps(a.vel + i);
+    const __m256 p00 = _mm256_loadu_ps(a.p00 + i);
+    const __m256 p01 = _mm256_loadu_ps(a.p01 + i);
+    const __m256 p11 = _mm256_loadu_ps(a.p11 + i);
+    const __m256 z = _mm256_loadu_ps(a.z + i);
+
+    const __m256 s = _mm256_add_ps(p00, vr);
+    const __m256 k0 = _mm256_div_ps(p00, s);
+    const __m256 k1 = _mm256_div_ps(p01, s);
+    const __m256 innovation = _mm256_sub_ps(z, pos);
+
+    const __m256 new_pos = _mm256_add_ps(pos, _mm256_mul_ps(k0, innovation));
+    const __m256 new_vel = _mm256_add_ps(vel, _mm256_mul_ps(k1, innovation));
+    const __m256 new_p00 = _mm256_sub_ps(p00, _mm256_mul_ps(k0, p00));
+    const __m256 new_p01 = _mm256_sub_ps(p01, _mm256_mul_ps(k0, p01));
+    const __m256 new_p11 = _mm256_sub_ps(p11, _mm256_mul_ps(k1, p01));
+
+    _mm256_storeu_ps(a.pos + i, _mm256_blendv_ps(pos, new_pos, m));
+    _mm256_storeu_ps(a.vel + i, _mm256_blendv_ps(vel, new_vel, m));
+    _mm256_storeu_ps(a.p00 + i, _mm256_blendv_ps(p00, new_p00, m));
+    _mm256_storeu_ps(a.p01 + i, _mm256_blendv_ps(p01, new_p01, m));
+    _mm256_storeu_ps(a.p11 + i, _mm256_blendv_ps(p11, new_p11, m));
+  }
+  return i;
+}
+
+#elif RM_BATCHED_KF_NEON
+
+std::size_t predictNeon(const AxisView& a, std::size_t n, float dt, float q_pos, float q_vel)
+{
+  const float32x4_t vdt = vdupq_n_f32(dt);
+  const float32x4_t vtwo = vdupq_n_f32(2.0f);
+  const float32x4_t vqp = vdupq_n_f32(q_pos);
+  const float32x4_t vqv = vdupq_n_f32(q_vel);
+
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    float32x4_t pos = vld1q_f32(a.pos + i);
+    float32x4_t vel = vld1q_f32(a.vel + i);
+    float32x4_t p00 = vld1q_f32(a.p00 + i);
+    float32x4_t p01 = vld1q_f32(a.p01 + i);
+    float32x4_t p11 = vld1q_f32(a.p11 + i);
+
+    // 不使用 vfma，保持与标量实现相同的舍入
+    pos = vaddq_f32(pos, vmulq_f32(vel, vdt));
+    float32x4_t t = vaddq_f32(vmulq_f32(vtwo, p01), vmulq_f32(vdt, p11));
+    p00 = vaddq_f32(vaddq_f32(p00, vmulq_f32(vdt, t)), vqp);
+    p01 = vaddq_f32(p01, vmulq_f32(vdt, p11));
+    p11 = vaddq_f32(p11, vqv);
+
+    vst1q_f32(a.pos + i, pos);
+    vst1q_f32(a.p00 + i, p00);
+    vst1q_f32(a.p01 + i, p01);
+    vst1q_f32(a.p11 + i, p11);
+  }
+  return i;
+}
+
+std::size_t updateNeon(const AxisView& a, const unsigned char* mask, std::size_t n, float r)
+{
+  const float32x4_t vr = vdupq_n_f32(r);
+
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    // 4 字节掩码扩展为 4 个 32 位通道掩码
+    std::uint32_t bytes;
+    std::memcpy(&bytes, mask + i, sizeof(bytes));
+    if (bytes == 0) continue;
+    const uint8x8_t m8 = vtst_u8(vcreate_u8(bytes), vcreate_u8(bytes));
+    const uint32x4_t m = vreinterpretq_u32_s32(vmovl_s16(vget_low_s16(
+        vmovl_s8(vreinterpret_s8_u8(m8)))));
+
+    const float32x4_t pos = vld1q_f32(a.pos + i);
+    const float32x4_t vel = vld1q_f32(a.vel + i);
+    const float32x4_t p00 = vld1q_f32(a.p00 + i);
+    const float32x4_t p01 = vld1q_f32(a.p01 + i);
+    const float32x4_t p11 = vld1q_f32(a.p11 + i);
+    const float32x4_t z = vld1q_f32(a.z + i);
+
+    const float32x4_t s = vaddq_f32(p00, vr);
+    const float32x4_t k0 = vdivq_f32(p00, s);
+    const float32x4_t k1 = vdivq_f32(p01, s);
+    const float32x4_t innovation = vsubq_f32(z, pos);
+
+    vst1q_f32(a.pos + i, vbslq_f32(m, vaddq_f32(pos, vmulq_f32(k0, innovation)), pos));
+    vst1q_f32(a.vel + i, vbslq_f32(m, vaddq_f32(vel, vmulq_f32(k1, innovation)), vel));
+    vst1q_f32(a.p00 + i, vbslq_f32(m, vsubq_f32(p00, vmulq_f32(k0, p00)), p00));
+    vst1q_f32(a.p01 + i, vbslq_f32(m, vsubq_f32(p01, vmulq_f32(k0, p01)), p01));
+    vst1q_f32(a.p11 + i, vbslq_f32(m, vsubq_f32(p11, vmulq_f32(k1, p01)), p11));
+  }
+  return i;
+}
+
+#endif
+
+}  // namespace
+
+BatchedKalmanFilter::BatchedKalmanFilter(std::size_t capacity, bool use_simd)
+: use_simd_(use_simd)
+{
+  reserveAxis(x_, capacity);
+  reserveAxis(y_, capacity);
+  has_measurement_.reserve(capacity);
+}
+
+void BatchedKalmanFilter::reserveAxis(Axis& axis, std::size_t capacity)
+{
+  axis.pos.reserve(capacity);
+  axis.vel.reserve(capacity);
+  axis.p00.reserve(capacity);
+  axis.p01.reserve(capacity);
+  axis.p11.reserve(capacity);
+  axis.z.reserve(capacity);
+}
+
+void BatchedKalmanFilter::addAxis(Axis& axis, float pos, float p0)
+{
+  axis.pos.push_back(pos);
+  axis.vel.push_back(0.0f);
+  axis.p00.push_back(p0);
+  axis.p01.push_back(0.0f);
+  axis.p11.push_back(p0);
+  axis.z.push_back(pos);
+}
+
+void BatchedKalmanFilter::removeAxis(Axis& axis, int i)
+{
+  const std::size_t last = axis.pos.size() - 1;
+  axis.pos[i] = axis.pos[last];
+  axis.vel[i] = axis.vel[last];
+  axis.p00[i] = axis.p00[last];
+  axis.p01[i] = axis.p01[last];
+  axis.p11[i] = axis.p11[last];
+  axis.z[i] = axis.z[last];
+  axis.pos.pop_back();
+  axis.vel.pop_back();
+  axis.p00.pop_back();
+  axis.p01.pop_back();
+  axis.p11.pop_back();
+  axis.z.pop_back();
+}
+
+int BatchedKalmanFilter::add(const cv::Point2f& initial_pos)
+{
+  addAxis(x_, initial_pos.x, p0_);
+  addAxis(y_, initial_pos.y, p0_);
+  has_measurement_.push_back(0);
+  return static_cast<int>(size()) - 1;
+}
+
+void BatchedKalmanFilter::remove(int i)
+{
+  if (i < 0 || i >= static_cast<int>(size())) return;
+  removeAxis(x_, i);
+  removeAxis(y_, i);
+  has_measurement_[i] = has_measurement_.back();
+  has_measurement_.pop_back();
+}
+
+void BatchedKalmanFilter::clear()
+{
+  for (Axis* axis : {&x_, &y_}) {
+    axis->pos.clear();
+    axis->vel.clear();
+    axis->p00.clear();
+    axis->p01.clear();
+    axis->p11.clear();
+    axis->z.clear();
+  }
+  has_measurement_.clear();
+  any_measurement_ = false;
+}
+
+void BatchedKalmanFilter::predict(float dt)
+{
+  const float scale = dt / nominalDt_;
+  predictAxis(x_, dt, qPos_ * scale, qVel_ * scale);
+  predictAxis(y_, dt, qPos_ * scale, qVel_ * scale);
+}
+
+void BatchedKalmanFilter::predictAxis(Axis& axis, float dt, float q_pos, float q_vel)
+{
+  const std::size_t n = axis.pos.size();
+  const AxisView view{axis.pos.data(), axis.vel.data(), axis.p00.data(),
+                      axis.p01.data(), axis.p11.data(), axis.z.data()};
+
+  std::size_t i = 0;
+#if RM_BATCHED_KF_X86
+  static const bool has_avx2 = __builtin_cpu_supports("avx2");
+  if (use_simd_ && has_avx2) {
+    i = predictAvx2(view, n, dt, q_pos, q_vel);
+  }
+#elif RM_BATCHED_KF_NEON
+  if (use_simd_) {
+    i = predictNeon(view, n, dt, q_pos, q_vel);
+  }
+#endif
+  predictScalar(view, i, n, dt, q_pos, q_vel);
+}
+
+void BatchedKalmanFilter::setMeasurement(int i, const cv::Point2f& measurement)
+{
+  x_.z[i] = measurement.x;
+  y_.z[i] = measurement.y;
+  has_measurement_[i] = 1;
+  any_measurement_ = true;
+}
+
+void BatchedKalmanFilter::update()
+{
+  if (!any_measurement_) return;
+
+  updateAxis(x_);
+  updateAxis(y_);
+  std::fill(has_measurement_.begin(), has_measurement_.end(), 0);
+  any_measurement_ = false;
+}
+
+void BatchedKalmanFilter::updateAxis(Axis& axis)
+{
+  const std::size_t n = axis.pos.size();
+  const AxisView view{axis.pos.data(), axis.vel.data(), axis.p00.data(),
+                      axis.p01.data(), axis.p11.data(), axis.z.data()};
+  const unsigned char* mask = has_measurement_.data();
+
+  std::size_t i = 0;
+#if RM_BATCHED_KF_X86
+  static const bool has_avx2 = __builtin_cpu_supports("avx2");
+  if (use_simd_ && has_avx2) {
+    i = updateAvx2(view, mask, n, r_);
+  }
+#elif RM_BATCHED_KF_NEON
+  if (use_simd_) {
+    i = updateNeon(view, mask, n, r_);
+  }
+#endif
+  updateScalar(view, mask, i, n, r_);
+}
+
+}  // namespace rm_auto_aim
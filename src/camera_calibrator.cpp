@@ -55,6 +55,7 @@ bool CameraCalibrator::calibrateFromChessboard(const std::string& image_dir,
     
     // 执行相机标定
     std::vector<cv::Mat> rvecs, tvecs;
+    clearUndistortMaps();
     calibration_error_ = cv::calibrateCamera(object_points, image_points, 
                                             cv::Size(image_paths.size() > 0 ? 
                                                     cv::imread(image_paths[0]).size() : cv::Size(640, 480)),
@@ -137,6 +138,7 @@ bool CameraCalibrator::loadCalibration(const std::string& file_path) {
     fs["calibration_error"] >> calibration_error_;
     
     fs.release();
+    clearUndistortMaps();
     
     std::cout << "[INFO] Loaded calibration from: " << file_path << std::endl;
     std::cout << "  - Calibration error: " << calibration_error_ << std::endl;
@@ -147,16 +149,70 @@ bool CameraCalibrator::loadCalibration(const std::string& file_path) {
 void CameraCalibrator::setCameraParams(const cv::Mat& camera_matrix, const cv::Mat& dist_coeffs) {
     camera_matrix_ = camera_matrix.clone();
     dist_coeffs_ = dist_coeffs.clone();
+    clearUndistortMaps();
+}
+
+void CameraCalibrator::clearUndistortMaps() {
+    std::lock_guard<std::mutex> lock(map_mutex_);
+    map1_ = cv::Mat();
+    map2_ = cv::Mat();
+    map_size_ = cv::Size();
+}
+
+bool CameraCalibrator::getUndistortMaps(const cv::Size& image_size, cv::Mat& map1, cv::Mat& map2) const {
+    if (camera_matrix_.empty() || dist_coeffs_.empty() || image_size.area() <= 0) {
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(map_mutex_);
+    if (map_size_ != image_size || map1_.empty()) {
+        // 与 cv::undistort 相同：不做校正旋转，新相机矩阵取原相机矩阵
+        cv::Mat new_map1, new_map2;
+        cv::initUndistortRectifyMap(camera_matrix_, dist_coeffs_, cv::Mat(), camera_matrix_,
+                                    image_size, CV_16SC2, new_map1, new_map2);
+        map1_ = new_map1;
+        map2_ = new_map2;
+        map_size_ = image_size;
+        std::cout << "[INFO] Built undistortion maps for " << image_size.width << "x"
+                  << image_size.height << std::endl;
+    }
+    map1 = map1_;
+    map2 = map2_;
+    return true;
+}
+
+bool CameraCalibrator::initUndistortMaps(const cv::Size& image_size) const {
+    cv::Mat map1, map2;
+    return getUndistortMaps(image_size, map1, map2);
 }
 
 void CameraCalibrator::undistortImage(const cv::Mat& src, cv::Mat& dst) const {
-    if (camera_matrix_.empty() || dist_coeffs_.empty()) {
+    cv::Mat map1, map2;
+    if (!getUndistortMaps(src.size(), map1, map2)) {
         std::cerr << "[WARNING] Camera parameters not set for undistortion" << std::endl;
         src.copyTo(dst);
         return;
     }
     
-    cv::undistort(src, dst, camera_matrix_, dist_coeffs_);
+    // remap 内部按行并行；定点映射表走查表插值，比浮点映射表快
+    cv::remap(src, dst, map1, map2, cv::INTER_LINEAR, cv::BORDER_CONSTANT);
+}
+
+void CameraCalibrator::undistortImage(const cv::Mat& src, cv::Mat& dst, const cv::Rect& roi) const {
+    const cv::Rect window = roi & cv::Rect(cv::Point(0, 0), src.size());
+    cv::Mat map1, map2;
+    if (window.area() <= 0 || !getUndistortMaps(src.size(), map1, map2)) {
+        if (window.area() > 0) {
+            std::cerr << "[WARNING] Camera parameters not set for undistortion" << std::endl;
+            src(window).copyTo(dst);
+        } else {
+            dst.release();
+        }
+        return;
+    }
+    
+    // 映射表取子区域即可：其中的坐标仍指向整幅源图像
+    cv::remap(src, dst, map1(window), map2(window), cv::INTER_LINEAR, cv::BORDER_CONSTANT);
 }
 
 bool CameraCalibrator::saveCalibration(const std::string& file_path) const {
@@ -0,0 +1,67 @@
+#include <algorithm>
+#include "armor_detector/camera_model.hpp"
+
+namespace rm_auto_aim {
+
+void CameraModel::set(const cv::Mat& camera_matrix, const cv::Mat& dist_coeffs) {
+    fx = fy = cx = cy = 0.0;
+    std::fill(std::begin(dist), std::end(dist), 0.0);
+    has_distortion = false;
+    if (camera_matrix.empty()) {
+        return;
+    }
+    
+    cv::Mat k;
+    camera_matrix.convertTo(k, CV_64F);
+    fx = k.at<double>(0, 0);
+    fy = k.at<double>(1, 1);
+    cx = k.at<double>(0, 2);
+    cy = k.at<double>(1, 2);
+    
+    if (!dist_coeffs.empty()) {
+        cv::Mat d;
+        dist_coeffs.reshape(1, 1).convertTo(d, CV_64F);
+        const int count = std::min(static_cast<int>(d.total()), 8);
+        for (int i = 0; i < count; ++i) {
+            dist[i] = d.at<double>(0, i);
+            has_distortion = has_distortion || dist[i] != 0.0;
+        }
+    }
+}
+
+cv::Point2d CameraModel::undistortNormalized(const cv::Point2f& pixel) const {
+    const double x0 = (pixel.x - cx) / fx;
+    const double y0 = (pixel.y - cy) / fy;
+    if (!has_distortion) {
+        return cv::Point2d(x0, y0);
+    }
+    
+    const double k1 = dist[0], k2 = dist[1], p1 = dist[2], p2 = dist[3];
+    const double k3 = dist[4], k4 = dist[5], k5 = dist[6], k6 = dist[7];
+    double x = x0, y = y0;
+    for (int i = 0; i < 5; ++i) {
+        const double r2 = x * x + y * y;
+        const double icdist = (1.0 + ((k6 * r2 + k5) * r2 + k4) * r2) / (1.0 + ((k3 * r2 + k2) * r2 + k1) * r2);
+        const double dx = 2.0 * p1 * x * y + p2 * (r2 + 2.0 * x * x);
+        const double dy = p1 * (r2 + 2.0 * y * y) + 2.0 * p2 * x * y;
+        x = (x0 - dx) * icdist;
+        y = (y0 - dy) * icdist;
+    }
+    return cv::Point2d(x, y);
+}
+
+cv::Point2d CameraModel::projectNormalized(double x, double y) const {
+    if (has_distortion) {
+        const double k1 = dist[0], k2 = dist[1], p1 = dist[2], p2 = dist[3];
+        const double k3 = dist[4], k4 = dist[5], k5 = dist[6], k6 = dist[7];
+        const double r2 = x * x + y * y;
+        const double radial = (1.0 + ((k3 * r2 + k2) * r2 + k1) * r2) / (1.0 + ((k6 * r2 + k5) * r2 + k4) * r2);
+        const double xd = x * radial + 2.0 * p1 * x * y + p2 * (r2 + 2.0 * x * x);
+        const double yd = y * radial + p1 * (r2 + 2.0 * y * y) + 2.0 * p2 * x * y;
+        x = xd;
+        y = yd;
+    }
+    return cv::Point2d(fx * x + cx, fy * y + cy);
+}
+
+} // namespace rm_auto_aim
@@ -0,0 +1,516 @@
+#include <opencv2/core.hpp>
+#include <algorithm>
+#include "armor_detector/color_mask.hpp"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define RM_COLOR_MASK_X86 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define RM_COLOR_MASK_NEON 1
+#endif
+
+namespace rm_auto_aim {
+
+namespace {
+
+constexpr int kHsvShift = 12;
+constexpr int kHsvRound = 1 << (kHsvShift - 1);
+constexpr int kMaxRanges = 2;
+constexpr size_t kParallelMinPixels = 640 * 480;
+
+// 与 OpenCV RGB2HSV_b 完全相同的定点除法表（H 范围 180）
+struct HsvTables {
+    int sdiv[256];
+    int hdiv[256];
+
+    HsvTables() {
+        sdiv[0] = hdiv[0] = 0;
+        for (int i = 1; i < 256; ++i) {
+            sdiv[i] = cvRound((255 << kHsvShift) / (1.0 * i));
+            hdiv[i] = cvRound((180 << kHsvShift) / (6.0 * i));
+        }
+    }
+};
+
+const HsvTables& hsvTables() {
+    static const HsvTables tables;
+    return tables;
+}
+
+struct MaskParams {
+    const HsvTables* tables;
+    HsvRange ranges[kMaxRanges];
+    int range_count;
+    // 所有区间V阈值的并集，用于快速跳过暗像素
+    int v_lo, v_hi;
+};
+
+// 单像素：逐条复现 RGB2HSV_b 的整数运算，再做区间判断
+inline uchar classifyPixel(int b, int g, int r, const MaskParams& mp) {
+    int v = std::max(b, std::max(g, r));
+    if (v < mp.v_lo || v > mp.v_hi) return 0;
+
+    int vmin = std::min(b, std::min(g, r));
+    int diff = v - vmin;
+    int vr = v == r ? -1 : 0;
+    int vg = v == g ? -1 : 0;
+
+    int s = (diff * mp.tables->sdiv[v] + kHsvRound) >> kHsvShift;
+    int h = (vr & (g - b)) +
+            (~vr & ((vg & (b - r + 2 * diff)) + (~vg & (r - g + 4 * diff))));
+    h = (h * mp.tables->hdiv[diff] + kHsvRound) >> kHsvShift;
+    h += h < 0 ? 180 : 0;
+    h = std::min(std::max(h, 0), 255);
+
+    for (int k = 0; k < mp.range_count; ++k) {
+        const HsvRange& rg = mp.ranges[k];
+        if (h >= rg.h_min && h <= rg.h_max &&
+            s >= rg.s_min && s <= rg.s_max &&
+            v >= rg.v_min && v <= rg.v_max) {
+            return 255;
+        }
+    }
+    return 0;
+}
+
+void maskRowScalar(const uchar* src, uchar* dst, int x0, int width, const MaskParams& mp) {
+    for (int x = x0; x < width; ++x) {
+        const uchar* p = src + x * 3;
+        dst[x] = classifyPixel(p[0], p[1], p[2], mp);
+    }
+}
+
+#if RM_COLOR_MASK_X86
+
+// 8个像素（32位通道）的精确 HSV 判断，查表使用 gather
+__attribute__((target("avx2")))
+inline __m256i classify8Avx2(__m256i b, __m256i g, __m256i r,
+                             const MaskParams& mp,
+                             const __m256i* lo, const __m256i* hi) {
+    const __m256i round = _mm256_set1_epi32(kHsvRound);
+    const __m256i zero = _mm256_setzero_si256();
+
+    __m256i v = _mm256_max_epi32(b, _mm256_max_epi32(g, r));
+    __m256i vmin = _mm256_min_epi32(b, _mm256_min_epi32(g, r));
+    __m256i diff = _mm256_sub_epi32(v, vmin);
+    __m256i vr = _mm256_cmpeq_epi32(v, r);
+    __m256i vg = _mm256_cmpeq_epi32(v, g);
+
+    __m256i sdiv = _mm256_i32gather_epi32(mp.tables->sdiv, v, 4);
+    __m256i s = _mm256_srai_epi32(
+        _mm256_add_epi32(_mm256_mullo_epi32(diff, sdiv), round), kHsvShift);
+
+    __m256i diff2 = _mm256_add_epi32(diff, diff);
+    __m256i h_r = _mm256_sub_epi32(g, b);
+    __m256i h_g = _mm256_add_epi32(_mm256_sub_epi32(b, r), diff2);
+    __m256i h_b = _mm256_add_epi32(_mm256_sub_epi32(r, g), _mm256_add_epi32(diff2, diff2));
+    __m256i h = _mm256_add_epi32(
+        _mm256_and_si256(vr, h_r),
+        _mm256_andnot_si256(vr, _mm256_add_epi32(_mm256_and_si256(vg, h_g),
+                                                 _mm256_andnot_si256(vg, h_b))));
+    __m256i hdiv = _mm256_i32gather_epi32(mp.tables->hdiv, diff, 4);
+    h = _mm256_srai_epi32(_mm256_add_epi32(_mm256_mullo_epi32(h, hdiv), round), kHsvShift);
+    h = _mm256_add_epi32(h, _mm256_and_si256(_mm256_cmpgt_epi32(zero, h),
+                                             _mm256_set1_epi32(180)));
+    h = _mm256_min_epi32(_mm256_max_epi32(h, zero), _mm256_set1_epi32(255));
+
+    __m256i hit = zero;
+    for (int k = 0; k < mp.range_count; ++k) {
+        const __m256i* l = lo + k * 3;
+        const __m256i* u = hi + k * 3;
+        __m256i out = _mm256_or_si256(_mm256_cmpgt_epi32(l[0], h), _mm256_cmpgt_epi32(h, u[0]));
+        out = _mm256_or_si256(out, _mm256_or_si256(_mm256_cmpgt_epi32(l[1], s),
+                                                   _mm256_cmpgt_epi32(s, u[1])));
+        out = _mm256_or_si256(out, _mm256_or_si256(_mm256_cmpgt_epi32(l[2], v),
+                                                   _mm256_cmpgt_epi32(v, u[2])));
+        hit = _mm256_or_si256(hit, _mm256_andnot_si256(out, _mm256_set1_epi32(-1)));
+    }
+    return hit;
+}
+
+// 每次处理16个像素：pshufb 拆分BGR，先按V阈值整块跳过暗像素，再逐像素精确计算
+__attribute__((target("avx2")))
+int maskRowAvx2(const uchar* src, uchar* dst, int width, const MaskParams& mp) {
+    const __m128i b_a = _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i b_b = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1);
+    const __m128i b_c = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13);
+    const __m128i g_a = _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i g_b = _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1);
+    const __m128i g_c = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14);
+    const __m128i r_a = _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i r_b = _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1);
+    const __m128i r_c = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15);
+
+    const __m128i v_lo = _mm_set1_epi8(static_cast<char>(mp.v_lo));
+    const __m128i v_hi = _mm_set1_epi8(static_cast<char>(mp.v_hi));
+
+    __m256i lo[kMaxRanges * 3], hi[kMaxRanges * 3];
+    for (int k = 0; k < mp.range_count; ++k) {
+        const HsvRange& rg = mp.ranges[k];
+        lo[k * 3 + 0] = _mm256_set1_epi32(rg.h_min);
+        hi[k * 3 + 0] = _mm256_set1_epi32(rg.h_max);
+        lo[k * 3 + 1] = _mm256_set1_epi32(rg.s_min);
+        hi[k * 3 + 1] = _mm256_set1_epi32(rg.s_max);
+        lo[k * 3 + 2] = _mm256_set1_epi32(rg.v_min);
+        hi[k * 3 + 2] = _mm256_set1_epi32(rg.v_max);
+    }
+
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        const uchar* p = src + x * 3;
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i m = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16));
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 32));
+
+        __m128i b8 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, b_a), _mm_shuffle_epi8(m, b_b)),
+                                  _mm_shuffle_epi8(c, b_c));
+        __m128i g8 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, g_a), _mm_shuffle_epi8(m, g_b)),
+                                  _mm_shuffle_epi8(c, g_c));
+        __m128i r8 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, r_a), _mm_shuffle_epi8(m, r_b)),
+                                  _mm_shuffle_epi8(c, r_c));
+
+        // v_lo <= V <= v_hi（无符号比较）
+        __m128i v8 = _mm_max_epu8(b8, _mm_max_epu8(g8, r8));
+        __m128i cand = _mm_and_si128(_mm_cmpeq_epi8(_mm_max_epu8(v8, v_lo), v8),
+                                     _mm_cmpeq_epi8(_mm_min_epu8(v8, v_hi), v8));
+        if (_mm_movemask_epi8(cand) == 0) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), _mm_setzero_si128());
+            continue;
+        }
+
+        __m256i m0 = classify8Avx2(_mm256_cvtepu8_epi32(b8), _mm256_cvtepu8_epi32(g8),
+                                   _mm256_cvtepu8_epi32(r8), mp, lo, hi);
+        __m256i m1 = classify8Avx2(_mm256_cvtepu8_epi32(_mm_srli_si128(b8, 8)),
+                                   _mm256_cvtepu8_epi32(_mm_srli_si128(g8, 8)),
+                                   _mm256_cvtepu8_epi32(_mm_srli_si128(r8, 8)), mp, lo, hi);
+
+        // 32位掩码 -> 8位掩码（packs 在128位内交错，需要重排）
+        __m256i m16 = _mm256_permute4x64_epi64(_mm256_packs_epi32(m0, m1), 0xD8);
+        __m128i m8 = _mm_packs_epi16(_mm256_castsi256_si128(m16),
+                                     _mm256_extracti128_si256(m16, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), m8);
+    }
+    return x;
+}
+
+#elif RM_COLOR_MASK_NEON
+
+// vld3q 拆分BGR后按V阈值整块跳过暗像素，候选像素走精确标量计算
+int maskRowNeon(const uchar* src, uchar* dst, int width, const MaskParams& mp) {
+    const uint8x16_t v_lo = vdupq_n_u8(static_cast<uint8_t>(mp.v_lo));
+    const uint8x16_t v_hi = vdupq_n_u8(static_cast<uint8_t>(mp.v_hi));
+
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        const uchar* p = src + x * 3;
+        uint8x16x3_t px = vld3q_u8(p);
+        uint8x16_t v = vmaxq_u8(px.val[0], vmaxq_u8(px.val[1], px.val[2]));
+        uint8x16_t cand = vandq_u8(vcgeq_u8(v, v_lo), vcleq_u8(v, v_hi));
+        if (vmaxvq_u8(cand) == 0) {
+            vst1q_u8(dst + x, vdupq_n_u8(0));
+            continue;
+        }
+
+        uint8_t cand_buf[16];
+        vst1q_u8(cand_buf, cand);
+        for (int i = 0; i < 16; ++i) {
+            const uchar* q = p + i * 3;
+            dst[x + i] = cand_buf[i] ? classifyPixel(q[0], q[1], q[2], mp) : 0;
+        }
+    }
+    return x;
+}
+
+#endif
+
+void maskRow(const uchar* src, uchar* dst, int width, const MaskParams& mp);
+
+// 按行分块的并行任务（ParallelLoopBody 不需要像 std::function 那样在堆上保存捕获）
+class MaskRowsBody : public cv::ParallelLoopBody {
+public:
+    MaskRowsBody(const cv::Mat& bgr, cv::Mat& mask, const MaskParams& mp)
+        : bgr_(bgr), mask_(mask), mp_(mp) {}
+
+    void operator()(const cv::Range& rows) const override {
+        for (int y = rows.start; y < rows.end; ++y) {
+            maskRow(bgr_.ptr<uchar>(y), mask_.ptr<uchar>(y), bgr_.cols, mp_);
+        }
+    }
+
+private:
+    const cv::Mat& bgr_;
+    cv::Mat& mask_;
+    const MaskParams& mp_;
+};
+
+void maskRow(const uchar* src, uchar* dst, int width, const MaskParams& mp) {
+    int x = 0;
+#if RM_COLOR_MASK_X86
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    if (has_avx2) {
+        x = maskRowAvx2(src, dst, width, mp);
+    }
+#elif RM_COLOR_MASK_NEON
+    x = maskRowNeon(src, dst, width, mp);
+#endif
+    maskRowScalar(src, dst, x, width, mp);
+}
+
+// 与 cv::pointPolygonTest(measureDist=false) 对浮点轮廓的判定逐条相同（边界上返回 true）
+inline bool insideOrOnQuad(const cv::Point2f* v, const cv::Point2f& pt) {
+    int counter = 0;
+    cv::Point2f v0, v1 = v[3];
+    for (int i = 0; i < 4; ++i) {
+        v0 = v1;
+        v1 = v[i];
+        if ((v0.y <= pt.y && v1.y <= pt.y) ||
+            (v0.y > pt.y && v1.y > pt.y) ||
+            (v0.x < pt.x && v1.x < pt.x)) {
+            if (pt.y == v1.y && (pt.x == v1.x || (pt.y == v0.y &&
+                ((v0.x <= pt.x && pt.x <= v1.x) || (v1.x <= pt.x && pt.x <= v0.x))))) {
+                return true;
+            }
+            continue;
+        }
+        double dist = (double)(pt.y - v0.y) * (v1.x - v0.x) - (double)(pt.x - v0.x) * (v1.y - v0.y);
+        if (dist == 0) return true;
+        if (v1.y < v0.y) dist = -dist;
+        counter += dist > 0;
+    }
+    return counter % 2 != 0;
+}
+
+// 一段连续像素的 B、R 通道求和
+void accumulateBR(const uchar* bgr, int count, long long& sum_b, long long& sum_r) {
+    int i = 0;
+#if RM_COLOR_MASK_X86
+    // 16个像素 = 3个向量；按字节位置取出 B/R 后用 psadbw 横向求和
+    const __m128i b_a = _mm_setr_epi8(-1, 0, 0, -1, 0, 0, -1, 0, 0, -1, 0, 0, -1, 0, 0, -1);
+    const __m128i b_b = _mm_setr_epi8(0, 0, -1, 0, 0, -1, 0, 0, -1, 0, 0, -1, 0, 0, -1, 0);
+    const __m128i b_c = _mm_setr_epi8(0, -1, 0, 0, -1, 0, 0, -1, 0, 0, -1, 0, 0, -1, 0, 0);
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc_b = zero, acc_r = zero;
+    for (; i + 16 <= count; i += 16) {
+        const uchar* p = bgr + i * 3;
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i m = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16));
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 32));
+        // R 的字节位置与 B 错开一个字节：三个向量依次复用 B 的掩码 b_b、b_c、b_a
+        acc_b = _mm_add_epi64(acc_b, _mm_sad_epu8(_mm_and_si128(a, b_a), zero));
+        acc_b = _mm_add_epi64(acc_b, _mm_sad_epu8(_mm_and_si128(m, b_b), zero));
+        acc_b = _mm_add_epi64(acc_b, _mm_sad_epu8(_mm_and_si128(c, b_c), zero));
+        acc_r = _mm_add_epi64(acc_r, _mm_sad_epu8(_mm_and_si128(a, b_b), zero));
+        acc_r = _mm_add_epi64(acc_r, _mm_sad_epu8(_mm_and_si128(m, b_c), zero));
+        acc_r = _mm_add_epi64(acc_r, _mm_sad_epu8(_mm_and_si128(c, b_a), zero));
+    }
+    sum_b += _mm_cvtsi128_si64(acc_b) + _mm_cvtsi128_si64(_mm_unpackhi_epi64(acc_b, acc_b));
+    sum_r += _mm_cvtsi128_si64(acc_r) + _mm_cvtsi128_si64(_mm_unpackhi_epi64(acc_r, acc_r));
+#elif RM_COLOR_MASK_NEON
+    uint32x4_t acc_b = vdupq_n_u32(0), acc_r = vdupq_n_u32(0);
+    for (; i + 16 <= count; i += 16) {
+        uint8x16x3_t px = vld3q_u8(bgr + i * 3);
+        acc_b = vpadalq_u16(acc_b, vpaddlq_u8(px.val[0]));
+        acc_r = vpadalq_u16(acc_r, vpaddlq_u8(px.val[2]));
+    }
+    sum_b += vaddvq_u32(acc_b);
+    sum_r += vaddvq_u32(acc_r);
+#endif
+    for (; i < count; ++i) {
+        sum_b += bgr[i * 3];
+        sum_r += bgr[i * 3 + 2];
+    }
+}
+
+// d[i] = op(a[i], b[i], c[i])，op 为 max（膨胀）或 min（腐蚀）
+template <bool kMax>
+void combine3(const uchar* a, const uchar* b, const uchar* c, uchar* d, int n) {
+    int i = 0;
+#if RM_COLOR_MASK_X86
+    for (; i + 16 <= n; i += 16) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+        __m128i vc = _mm_loadu_si128(reinterpret_cast<const __m128i*>(c + i));
+        __m128i r = kMax ? _mm_max_epu8(_mm_max_epu8(va, vb), vc)
+                         : _mm_min_epu8(_mm_min_epu8(va, vb), vc);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(d + i), r);
+    }
+#elif RM_COLOR_MASK_NEON
+    for (; i + 16 <= n; i += 16) {
+        uint8x16_t va = vld1q_u8(a + i), vb = vld1q_u8(b + i), vc = vld1q_u8(c + i);
+        vst1q_u8(d + i, kMax ? vmaxq_u8(vmaxq_u8(va, vb), vc) : vminq_u8(vminq_u8(va, vb), vc));
+    }
+#endif
+    for (; i < n; ++i) {
+        d[i] = kMax ? std::max(std::max(a[i], b[i]), c[i]) : std::min(std::min(a[i], b[i]), c[i]);
+    }
+}
+
+// 3x3 膨胀/腐蚀：先水平（结果写入 tmp）再竖直（写回 img）。
+// 图像外的像素不参与，等价于边界复制，与 OpenCV 形态学的默认边界值一致
+template <bool kMax>
+void morph3x3(cv::Mat& img, cv::Mat& tmp) {
+    const int w = img.cols, h = img.rows;
+    for (int y = 0; y < h; ++y) {
+        const uchar* s = img.ptr<uchar>(y);
+        uchar* d = tmp.ptr<uchar>(y);
+        if (w == 1) {
+            d[0] = s[0];
+            continue;
+        }
+        d[0] = kMax ? std::max(s[0], s[1]) : std::min(s[0], s[1]);
+        combine3<kMax>(s, s + 1, s + 2, d + 1, w - 2);
+        d[w - 1] = kMax ? std::max(s[w - 2], s[w - 1]) : std::min(s[w - 2], s[w - 1]);
+    }
+    for (int y = 0; y < h; ++y) {
+        combine3<kMax>(tmp.ptr<uchar>(std::max(y - 1, 0)), tmp.ptr<uchar>(y),
+                       tmp.ptr<uchar>(std::min(y + 1, h - 1)), img.ptr<uchar>(y), w);
+    }
+}
+
+} // namespace
+
+HsvRange makeHsvRange(double h_min, double h_max,
+                      double s_min, double s_max,
+                      double v_min, double v_max) {
+    // cv::inRange：阈值先取整；下界大于上界或超出[0,255]时该通道为空区间
+    auto clampRange = [](double lo_d, double hi_d, int& lo, int& hi) {
+        lo = cvRound(lo_d);
+        hi = cvRound(hi_d);
+        if (lo > hi || lo > 255 || hi < 0) {
+            lo = 1;
+            hi = 0;
+            return;
+        }
+        lo = std::max(lo, 0);
+        hi = std::min(hi, 255);
+    };
+
+    HsvRange range;
+    clampRange(h_min, h_max, range.h_min, range.h_max);
+    clampRange(s_min, s_max, range.s_min, range.s_max);
+    clampRange(v_min, v_max, range.v_min, range.v_max);
+    return range;
+}
+
+void fusedColorMask(const cv::Mat& bgr, cv::Mat& mask,
+                    const HsvRange* ranges, int range_count) {
+    CV_Assert(bgr.type() == CV_8UC3);
+    CV_Assert(range_count >= 1 && range_count <= kMaxRanges);
+
+    mask.create(bgr.size(), CV_8UC1);
+
+    MaskParams mp;
+    mp.tables = &hsvTables();
+    mp.range_count = range_count;
+    mp.v_lo = 255;
+    mp.v_hi = 0;
+    for (int k = 0; k < range_count; ++k) {
+        mp.ranges[k] = ranges[k];
+        if (ranges[k].v_min <= ranges[k].v_max) {
+            mp.v_lo = std::min(mp.v_lo, ranges[k].v_min);
+            mp.v_hi = std::max(mp.v_hi, ranges[k].v_max);
+        }
+    }
+    if (mp.v_lo > mp.v_hi) {
+        // 所有区间均为空
+        mask.setTo(cv::Scalar::all(0));
+        return;
+    }
+
+    // 小图（如跟踪窗口）直接串行，避免线程调度开销
+    MaskRowsBody body(bgr, mask, mp);
+    if (bgr.total() >= kParallelMinPixels) {
+        cv::parallel_for_(cv::Range(0, bgr.rows), body);
+    } else {
+        body(cv::Range(0, bgr.rows));
+    }
+}
+
+void morphCloseOpen3x3(cv::Mat& mask, cv::Mat& tmp) {
+    CV_Assert(mask.type() == CV_8UC1 && tmp.type() == CV_8UC1);
+    CV_Assert(tmp.rows == mask.rows && tmp.cols == mask.cols);
+    if (mask.rows == 0 || mask.cols == 0) return;
+
+    // 闭运算 = 膨胀 + 腐蚀，开运算 = 腐蚀 + 膨胀
+    morph3x3<true>(mask, tmp);
+    morph3x3<false>(mask, tmp);
+    morph3x3<false>(mask, tmp);
+    morph3x3<true>(mask, tmp);
+}
+
+ColorVote voteLightColor(const cv::Mat& bgr, const cv::Point2f vertices[4],
+                         const cv::Rect& roi, const cv::Mat& mask) {
+    ColorVote vote;
+    const int x_min = roi.x, x_max = roi.x + roi.width - 1;
+    const bool use_mask = !mask.empty();
+
+    // 精确判定 [x0, x1] 内的每个像素
+    auto testRange = [&](const uchar* row, const uchar* mrow, int y, int x0, int x1) {
+        for (int x = std::max(x0, x_min); x <= std::min(x1, x_max); ++x) {
+            if (use_mask && !mrow[x]) continue;
+            if (insideOrOnQuad(vertices, cv::Point2f((float)x, (float)y))) {
+                vote.sum_b += row[x * 3];
+                vote.sum_r += row[x * 3 + 2];
+                vote.pixel_count++;
+            }
+        }
+    };
+
+    for (int y = roi.y; y < roi.y + roi.height; ++y) {
+        const uchar* row = bgr.ptr<uchar>(y);
+        const uchar* mrow = use_mask ? mask.ptr<uchar>(y) : nullptr;
+
+        // 水平线 y 与四条边的交点区间；近乎水平的边附近数值不稳定，整行精确判定
+        double x_left = 1e30, x_right = -1e30;
+        bool ill_conditioned = false;
+        for (int i = 0; i < 4; ++i) {
+            const cv::Point2f& a = vertices[i];
+            const cv::Point2f& b = vertices[(i + 1) % 4];
+            double lo = std::min(a.y, b.y), hi = std::max(a.y, b.y);
+            if (hi - lo < 1.0 && y >= lo - 1.0 && y <= hi + 1.0) {
+                ill_conditioned = true;
+                break;
+            }
+            if (y < lo || y > hi) continue;
+            double x = a.x + (y - (double)a.y) * (b.x - (double)a.x) / (b.y - (double)a.y);
+            x_left = std::min(x_left, x);
+            x_right = std::max(x_right, x);
+        }
+
+        if (ill_conditioned) {
+            testRange(row, mrow, y, x_min, x_max);
+            continue;
+        }
+        if (x_left > x_right) continue;
+
+        // 两端各留2像素做精确判定，中间整段必在内部
+        int left_end = cvCeil(x_left) + 2;
+        int right_begin = cvFloor(x_right) - 2;
+        if (left_end + 1 >= right_begin) {
+            testRange(row, mrow, y, cvFloor(x_left) - 2, cvCeil(x_right) + 2);
+            continue;
+        }
+        testRange(row, mrow, y, cvFloor(x_left) - 2, left_end);
+        testRange(row, mrow, y, right_begin, cvCeil(x_right) + 2);
+
+        int run_begin = std::max(left_end + 1, x_min);
+        int run_end = std::min(right_begin - 1, x_max);
+        if (run_begin > run_end) continue;
+        if (use_mask) {
+            for (int x = run_begin; x <= run_end; ++x) {
+                if (!mrow[x]) continue;
+                vote.sum_b += row[x * 3];
+                vote.sum_r += row[x * 3 + 2];
+                vote.pixel_count++;
+            }
+        } else {
+            accumulateBR(row + run_begin * 3, run_end - run_begin + 1, vote.sum_b, vote.sum_r);
+            vote.pixel_count += run_end - run_begin + 1;
+        }
+    }
+
+    return vote;
+}
+
+} // namespace rm_auto_aim
@@ -1,10 +1,190 @@
 #include "armor_detector/coordinate_transformer.hpp"
 #include "armor_detector/camera_calibrator.hpp"
+#include <algorithm>
 #include <iostream>
 
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define RM_TRANSFORMER_X86 1
+#endif
+
 namespace rm_auto_aim
 {
 
+namespace
+{
+
+// 与 CameraModel::undistortNormalized 相同的 5 次不动点迭代
+constexpr int kUndistortIterations = 5;
+
+void projectScalar(const CoordinateTransformer::Intrinsics& in, const cv::Point3f* points,
+                   cv::Point2f* pixels, std::size_t begin, std::size_t end)
+{
+  const float* k = in.dist;
+  for (std::size_t i = begin; i < end; ++i) {
+    const cv::Point3f& p = points[i];
+    if (!(p.z > 0.0f)) {
+      pixels[i] = cv::Point2f(0.0f, 0.0f);
+      continue;
+    }
+    const float iz = 1.0f / p.z;
+    float x = p.x * iz;
+    float y = p.y * iz;
+    if (in.has_distortion) {
+      const float r2 = x * x + y * y;
+      const float radial = (1.0f + ((k[4] * r2 + k[1]) * r2 + k[0]) * r2) /
+                           (1.0f + ((k[7] * r2 + k[6]) * r2 + k[5]) * r2);
+      const float xd = x * radial + 2.0f * k[2] * x * y + k[3] * (r2 + 2.0f * x * x);
+      const float yd = y * radial + k[2] * (r2 + 2.0f * y * y) + 2.0f * k[3] * x * y;
+      x = xd;
+      y = yd;
+    }
+    pixels[i] = cv::Point2f(in.fx * x + in.cx, in.fy * y + in.cy);
+  }
+}
+
+void backprojectScalar(const CoordinateTransformer::Intrinsics& in, bool undistort,
+                       const cv::Point2f* pixels, cv::Point3f* points,
+                       std::size_t begin, std::size_t end, float z)
+{
+  const float* k = in.dist;
+  for (std::size_t i = begin; i < end; ++i) {
+    const float x0 = (pixels[i].x - in.cx) * in.inv_fx;
+    const float y0 = (pixels[i].y - in.cy) * in.inv_fy;
+    float x = x0, y = y0;
+    if (undistort) {
+      for (int it = 0; it < kUndistortIterations; ++it) {
+        const float r2 = x * x + y * y;
+        const float icdist = (1.0f + ((k[7] * r2 + k[6]) * r2 + k[5]) * r2) /
+                             (1.0f + ((k[4] * r2 + k[1]) * r2 + k[0]) * r2);
+        const float dx = 2.0f * k[2] * x * y + k[3] * (r2 + 2.0f * x * x);
+        const float dy = k[2] * (r2 + 2.0f * y * y) + 2.0f * k[3] * x * y;
+        x = (x0 - dx) * icdist;
+        y = (y0 - dy) * icdist;
+      }
+    }
+    points[i] = cv::Point3f(x * z, y * z, z);
+  }
+}
+
+#if RM_TRANSFORMER_X86
+
+// 多项式 1 + ((c * r2 + b) * r2 + a) * r2
+__attribute__((target("avx2,fma")))
+inline __m256 poly3(__m256 r2, float a, float b, float c)
+{
+  __m256 v = _mm256_fmadd_ps(_mm256_set1_ps(c), r2, _mm256_set1_ps(b));
+  v = _mm256_fmadd_ps(v, r2, _mm256_set1_ps(a));
+  return _mm256_fmadd_ps(v, r2, _mm256_set1_ps(1.0f));
+}
+
+// 每次 8 个点：按步长 3 gather 出 X/Y/Z，投影后交错写回 (u, v)
+__attribute__((target("avx2,fma")))
+std::size_t projectAvx2(const CoordinateTransformer::Intrinsics& in, const cv::Point3f* points,
+                        cv::Point2f* pixels, std::size_t n)
+{
+  const __m256i stride3 = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+  const __m256 zero = _mm256_setzero_ps();
+  const __m256 one = _mm256_set1_ps(1.0f);
+  const __m256 two = _mm256_set1_ps(2.0f);
+  const __m256 fx = _mm256_set1_ps(in.fx), fy = _mm256_set1_ps(in.fy);
+  const __m256 cx = _mm256_set1_ps(in.cx), cy = _mm256_set1_ps(in.cy);
+  const __m256 p1 = _mm256_set1_ps(in.dist[2]), p2 = _mm256_set1_ps(in.dist[3]);
+  const float* k = in.dist;
+
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const float* base = reinterpret_cast<const float*>(points + i);
+    const __m256 px = _mm256_i32gather_ps(base, stride3, 4);
+    const __m256 py = _mm256_i32gather_ps(base + 1, stride3, 4);
+    const __m256 pz = _mm256_i32gather_ps(base + 2, stride3, 4);
+
+    const __m256 valid = _mm256_cmp_ps(pz, zero, _CMP_GT_OQ);
+    const __m256 iz = _mm256_div_ps(one, _mm256_blendv_ps(one, pz, valid));
+    __m256 x = _mm256_mul_ps(px, iz);
+    __m256 y = _mm256_mul_ps(py, iz);
+    if (in.has_distortion) {
+      const __m256 xy = _mm256_mul_ps(x, y);
+      const __m256 xx = _mm256_mul_ps(x, x);
+      const __m256 yy = _mm256_mul_ps(y, y);
+      const __m256 r2 = _mm256_add_ps(xx, yy);
+      const __m256 radial = _mm256_div_ps(poly3(r2, k[0], k[1], k[4]), poly3(r2, k[5], k[6], k[7]));
+      // xd = x * radial + 2 p1 xy + p2 (r2 + 2 x^2)，yd = y * radial + p1 (r2 + 2 y^2) + 2 p2 xy
+      const __m256 xd = _mm256_fmadd_ps(x, radial,
+                                        _mm256_fmadd_ps(_mm256_mul_ps(two, p1), xy,
+                                                        _mm256_mul_ps(p2, _mm256_fmadd_ps(two, xx, r2))));
+      const __m256 yd = _mm256_fmadd_ps(y, radial,
+                                        _mm256_fmadd_ps(_mm256_mul_ps(two, p2), xy,
+                                                        _mm256_mul_ps(p1, _mm256_fmadd_ps(two, yy, r2))));
+      x = xd;
+      y = yd;
+    }
+    const __m256 u = _mm256_and_ps(_mm256_fmadd_ps(fx, x, cx), valid);
+    const __m256 v = _mm256_and_ps(_mm256_fmadd_ps(fy, y, cy), valid);
+
+    // (u0 v0 u1 v1 | u4 v4 u5 v5) 与 (u2 v2 u3 v3 | u6 v6 u7 v7) 重排为连续的 8 个 Point2f
+    const __m256 lo = _mm256_unpacklo_ps(u, v);
+    const __m256 hi = _mm256_unpackhi_ps(u, v);
+    float* out = reinterpret_cast<float*>(pixels + i);
+    _mm256_storeu_ps(out, _mm256_permute2f128_ps(lo, hi, 0x20));
+    _mm256_storeu_ps(out + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+  }
+  return i;
+}
+
+__attribute__((target("avx2,fma")))
+std::size_t backprojectAvx2(const CoordinateTransformer::Intrinsics& in, bool undistort,
+                            const cv::Point2f* pixels, cv::Point3f* points, std::size_t n, float z)
+{
+  const __m256 two = _mm256_set1_ps(2.0f);
+  const __m256 cx = _mm256_set1_ps(in.cx), cy = _mm256_set1_ps(in.cy);
+  const __m256 inv_fx = _mm256_set1_ps(in.inv_fx), inv_fy = _mm256_set1_ps(in.inv_fy);
+  const __m256 p1 = _mm256_set1_ps(in.dist[2]), p2 = _mm256_set1_ps(in.dist[3]);
+  const __m256 vz = _mm256_set1_ps(z);
+  const float* k = in.dist;
+  alignas(32) float xs[8];
+  alignas(32) float ys[8];
+
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    // (u0 v0 .. u3 v3) 与 (u4 v4 .. u7 v7) 拆成 u、v 两路
+    const float* src = reinterpret_cast<const float*>(pixels + i);
+    const __m256 a = _mm256_loadu_ps(src);
+    const __m256 b = _mm256_loadu_ps(src + 8);
+    const __m256 t0 = _mm256_permute2f128_ps(a, b, 0x20);
+    const __m256 t1 = _mm256_permute2f128_ps(a, b, 0x31);
+    const __m256 u = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(2, 0, 2, 0));
+    const __m256 v = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 1, 3, 1));
+
+    const __m256 x0 = _mm256_mul_ps(_mm256_sub_ps(u, cx), inv_fx);
+    const __m256 y0 = _mm256_mul_ps(_mm256_sub_ps(v, cy), inv_fy);
+    __m256 x = x0, y = y0;
+    if (undistort) {
+      for (int it = 0; it < kUndistortIterations; ++it) {
+        const __m256 xy = _mm256_mul_ps(x, y);
+        const __m256 xx = _mm256_mul_ps(x, x);
+        const __m256 yy = _mm256_mul_ps(y, y);
+        const __m256 r2 = _mm256_add_ps(xx, yy);
+        const __m256 icdist = _mm256_div_ps(poly3(r2, k[5], k[6], k[7]), poly3(r2, k[0], k[1], k[4]));
+        const __m256 dx = _mm256_fmadd_ps(_mm256_mul_ps(two, p1), xy, _mm256_mul_ps(p2, _mm256_fmadd_ps(two, xx, r2)));
+        const __m256 dy = _mm256_fmadd_ps(_mm256_mul_ps(two, p2), xy, _mm256_mul_ps(p1, _mm256_fmadd_ps(two, yy, r2)));
+        x = _mm256_mul_ps(_mm256_sub_ps(x0, dx), icdist);
+        y = _mm256_mul_ps(_mm256_sub_ps(y0, dy), icdist);
+      }
+    }
+    _mm256_store_ps(xs, _mm256_mul_ps(x, vz));
+    _mm256_store_ps(ys, _mm256_mul_ps(y, vz));
+    for (int j = 0; j < 8; ++j) {
+      points[i + j] = cv::Point3f(xs[j], ys[j], z);
+    }
+  }
+  return i;
+}
+
+#endif
+
+} // namespace
+
 CoordinateTransformer::CoordinateTransformer()
 {
   camera_matrix_ = (cv::Mat_<double>(3, 3) << 
@@ -12,20 +192,44 @@ CoordinateTransformer::CoordinateTransformer()
     0.0, 1000.0, 240.0,
     0.0, 0.0, 1.0);
   dist_coeffs_ = cv::Mat::zeros(5, 1, CV_64F);
+  updateIntrinsics();
   params_initialized_ = true;
 }
 
+void CoordinateTransformer::updateIntrinsics()
+{
+  model_.set(camera_matrix_, dist_coeffs_);
+  
+  intrinsics_ = Intrinsics();
+  if (!model_.isValid()) return;
+  
+  intrinsics_.fx = static_cast<float>(model_.fx);
+  intrinsics_.fy = static_cast<float>(model_.fy);
+  intrinsics_.cx = static_cast<float>(model_.cx);
+  intrinsics_.cy = static_cast<float>(model_.cy);
+  intrinsics_.inv_fx = static_cast<float>(1.0 / model_.fx);
+  intrinsics_.inv_fy = static_cast<float>(1.0 / model_.fy);
+  for (int i = 0; i < 8; ++i) {
+    intrinsics_.dist[i] = static_cast<float>(model_.dist[i]);
+  }
+  intrinsics_.has_distortion = model_.has_distortion;
+}
+
 void CoordinateTransformer::setCameraMatrix(const cv::Mat& matrix)
 {
   if (!matrix.empty()) {
     matrix.copyTo(camera_matrix_);
+    updateIntrinsics();
     params_initialized_ = true;
   }
 }
 
 void CoordinateTransformer::setDistCoeffs(const cv::Mat& coeffs)
 {
-  if (!coeffs.empty()) coeffs.copyTo(dist_coeffs_);
+  if (!coeffs.empty()) {
+    coeffs.copyTo(dist_coeffs_);
+    updateIntrinsics();
+  }
 }
 
 void CoordinateTransformer::setCameraParams(const cv::Mat& camera_matrix, const cv::Mat& dist_coeffs)
@@ -42,6 +246,7 @@ void CoordinateTransformer::setCameraParamsFromCalibrator(const CameraCalibrator
   camera_matrix_.at<double>(0, 2) = 320;
   camera_matrix_.at<double>(1, 2) = 240;
   dist_coeffs_ = cv::Mat::zeros(5, 1, CV_64F);
+  updateIntrinsics();
   params_initialized_ = true;
   std::cout << "[CoordinateTransformer] Using default camera parameters" << std::endl;
 }
@@ -67,28 +272,69 @@ bool CoordinateTransformer::solvePnP(const std::vector<cv::Point2f>& image_point
   }
 }
 
-cv::Point3f CoordinateTransformer::pixelToWorld(const cv::Point2f& pixel_point, float z_world)
+cv::Point3f CoordinateTransformer::pixelToWorld(const cv::Point2f& pixel_point, float z_world, bool undistort) const
 {
-  if (!params_initialized_) return cv::Point3f(0, 0, 0);
-  
-  cv::Mat pixel_mat = (cv::Mat_<double>(3, 1) << pixel_point.x, pixel_point.y, 1);
-  cv::Mat inv_camera = camera_matrix_.inv();
-  cv::Mat world_mat = inv_camera * pixel_mat;
-  
-  double scale = z_world / world_mat.at<double>(2);
-  return cv::Point3f(world_mat.at<double>(0) * scale, world_mat.at<double>(1) * scale, z_world);
+  cv::Point3f point(0, 0, 0);
+  pixelToWorld(&pixel_point, &point, 1, z_world, undistort);
+  return point;
+}
+
+cv::Point2f CoordinateTransformer::worldToPixel(const cv::Point3f& world_point) const
+{
+  cv::Point2f pixel(0, 0);
+  worldToPixel(&world_point, &pixel, 1);
+  return pixel;
 }
 
-cv::Point2f CoordinateTransformer::worldToPixel(const cv::Point3f& world_point)
+void CoordinateTransformer::pixelToWorld(const cv::Point2f* pixels, cv::Point3f* points,
+                                         std::size_t count, float z_world, bool undistort) const
 {
-  if (!params_initialized_) return cv::Point2f(0, 0);
+  if (!params_initialized_ || !model_.isValid()) {
+    std::fill(points, points + count, cv::Point3f(0, 0, 0));
+    return;
+  }
   
-  cv::Mat world_mat = (cv::Mat_<double>(4, 1) << world_point.x, world_point.y, world_point.z, 1);
-  cv::Mat pixel_mat = camera_matrix_ * world_mat;
+  undistort = undistort && intrinsics_.has_distortion;
+  std::size_t i = 0;
+#if RM_TRANSFORMER_X86
+  static const bool has_avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+  if (has_avx2) {
+    i = backprojectAvx2(intrinsics_, undistort, pixels, points, count, z_world);
+  }
+#endif
+  backprojectScalar(intrinsics_, undistort, pixels, points, i, count, z_world);
+}
+
+void CoordinateTransformer::worldToPixel(const cv::Point3f* points, cv::Point2f* pixels,
+                                         std::size_t count) const
+{
+  if (!params_initialized_ || !model_.isValid()) {
+    std::fill(pixels, pixels + count, cv::Point2f(0, 0));
+    return;
+  }
   
-  if (pixel_mat.at<double>(2) == 0) return cv::Point2f(0, 0);
-  return cv::Point2f(pixel_mat.at<double>(0) / pixel_mat.at<double>(2),
-                     pixel_mat.at<double>(1) / pixel_mat.at<double>(2));
+  std::size_t i = 0;
+#if RM_TRANSFORMER_X86
+  static const bool has_avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+  if (has_avx2) {
+    i = projectAvx2(intrinsics_, points, pixels, count);
+  }
+#endif
+  projectScalar(intrinsics_, points, pixels, i, count);
+}
+
+void CoordinateTransformer::pixelToWorld(const std::vector<cv::Point2f>& pixels,
+                                         std::vector<cv::Point3f>& points, float z_world, bool undistort) const
+{
+  points.resize(pixels.size());
+  pixelToWorld(pixels.data(), points.data(), pixels.size(), z_world, undistort);
+}
+
+void CoordinateTransformer::worldToPixel(const std::vector<cv::Point3f>& points,
+                                         std::vector<cv::Point2f>& pixels) const
+{
+  pixels.resize(points.size());
+  worldToPixel(points.data(), pixels.data(), points.size());
 }
 
 } // namespace rm_auto_aim
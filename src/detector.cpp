@@ -5,6 +5,8 @@
 #include <iomanip>
 #include <algorithm>
 #include "armor_detector/detector.hpp"
+#include "armor_detector/color_mask.hpp"
+#include "armor_detector/alloc_counter.hpp"
 
 namespace rm_auto_aim {
 
@@ -14,81 +16,200 @@ Detector::Detector(const DetectorParams& params) : params_(params) {
     std::cout << "[INIT] Detector initialized with armor matching" << std::endl;
 }
 
-std::vector<Armor> Detector::detect(const cv::Mat& rgb_img) {
+const std::vector<Armor>& Detector::detect(const cv::Mat& rgb_img) {
+    return detect(rgb_img, cv::Rect());
+}
+
+const std::vector<Armor>& Detector::detect(const cv::Mat& rgb_img, const cv::Rect& roi_hint,
+                                           double timestamp) {
     auto start_time = Clock::now();
+    const std::size_t alloc_start = alloc_counter::count();
     debug_info_ = DebugInfo();
+    if (timestamp < 0.0) {
+        timestamp = std::chrono::duration<double>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
     
-    // 1. 预处理
-    binary_img_ = preprocess(rgb_img);
+    const cv::Rect full_rect(0, 0, rgb_img.cols, rgb_img.rows);
+    cv::Rect roi = roi_hint & full_rect;
+    
+    // 判断本帧是否可以只在搜索窗口内检测
+    bool use_roi = params_.roi.enable &&
+                   roi.width >= params_.roi.min_size &&
+                   roi.height >= params_.roi.min_size &&
+                   roi.area() < full_rect.area();
+    if (use_roi && params_.roi.full_scan_interval > 0 &&
+        frames_since_full_scan_ >= params_.roi.full_scan_interval) {
+        use_roi = false;  // 定期全图检测，防止漏掉窗口外的新目标
+    }
     
-    // 2. 查找灯条
-    lights_ = findLights(rgb_img, binary_img_);
+    bool full_frame = !use_roi;
+    if (use_roi) {
+        runDetection(rgb_img(roi), roi.tl());
+        if (armors_.empty()) {
+            // 窗口内未找到装甲板，本帧回退到全图检测
+            debug_info_ = DebugInfo();
+            full_frame = true;
+        }
+    }
     
-    // 3. 匹配装甲板
-    armors_ = matchLights(lights_);
+    if (full_frame) {
+        runDetection(rgb_img, cv::Point(0, 0));
+        frames_since_full_scan_ = 0;
+    } else {
+        frames_since_full_scan_++;
+    }
     
     auto end_time = Clock::now();
     debug_info_.process_time_ms = 
         std::chrono::duration<double, std::milli>(end_time - start_time).count();
     debug_info_.armors_found = armors_.size();
+    debug_info_.full_frame = full_frame;
+    debug_info_.search_roi = full_frame ? full_rect : roi;
+    debug_info_.allocations = alloc_counter::count() - alloc_start;
+    debug_info_.timestamp = timestamp;
+    
+    if (!params_.log_frames) {
+        return armors_;
+    }
     
-    std::cout << "[DEBUG] Frame: " 
+    std::cout << "[DEBUG] Frame" << (full_frame ? "" : " (ROI)") << ": " 
               << debug_info_.contours_found << " contours -> " 
               << debug_info_.lights_found << " lights -> " 
               << debug_info_.target_color_lights << " target lights -> "
               << debug_info_.armors_found << " armors"
               << " (" << std::fixed << std::setprecision(2) 
-              << debug_info_.process_time_ms << " ms)" << std::endl;
+              << debug_info_.process_time_ms << " ms";
+    if (debug_info_.lights_found > 0) {
+        std::cout << ", color " << debug_info_.color_time_ms * 1000.0 / debug_info_.lights_found
+                  << " us/light";
+    }
+    if (alloc_counter::enabled()) {
+        std::cout << ", " << debug_info_.allocations << " allocs";
+    }
+    std::cout << ")" << std::endl;
     
     return armors_;
 }
 
+FrameHandle Detector::detectFrame(const cv::Mat& rgb_img, const cv::Rect& roi_hint,
+                                  double timestamp) {
+    detect(rgb_img, roi_hint, timestamp);
+    
+    // 结果复制进帧池中的连续数组，复用帧的已有容量
+    FrameHandle handle = arena_.acquire();
+    DetectionFrame* frame = handle.edit();
+    frame->timestamp = debug_info_.timestamp;
+    frame->search_roi = debug_info_.search_roi;
+    frame->full_frame = debug_info_.full_frame;
+    frame->lights.assign(target_lights_.begin(), target_lights_.end());
+    frame->armors.assign(armors_.begin(), armors_.end());
+    return handle;
+}
+
+void Detector::runDetection(const cv::Mat& rgb_img, const cv::Point& offset) {
+    // 1. 预处理
+    binary_img_ = preprocess(rgb_img);
+    
+    // 2. 查找灯条，并把窗口内坐标换算回整幅图像
+    findLights(rgb_img, binary_img_, lights_);
+    if (offset != cv::Point(0, 0)) {
+        const cv::Point2f shift(offset);
+        for (auto& light : lights_) {
+            light.rect.center += shift;
+            light.center += shift;
+            light.top += shift;
+            light.bottom += shift;
+        }
+    }
+    
+    // 3. 匹配装甲板
+    matchLights(lights_, armors_);
+}
+
 cv::Mat Detector::preprocess(const cv::Mat& rgb_img) {
     if (rgb_img.empty() || rgb_img.channels() != 3) {
         return cv::Mat();
     }
     
-    cv::Mat hsv_img;
-    cv::cvtColor(rgb_img, hsv_img, cv::COLOR_BGR2HSV);
-    
-    cv::Mat color_mask;
-    
-    if (params_.detect_color == RED) {
-        cv::Mat mask1, mask2;
-        cv::inRange(hsv_img, 
-                   cv::Scalar(params_.hsv_red.h1_min, params_.hsv_red.s_min, params_.hsv_red.v_min),
-                   cv::Scalar(params_.hsv_red.h1_max, params_.hsv_red.s_max, params_.hsv_red.v_max),
-                   mask1);
-        
-        cv::inRange(hsv_img,
-                   cv::Scalar(params_.hsv_red.h2_min, params_.hsv_red.s_min, params_.hsv_red.v_min),
-                   cv::Scalar(params_.hsv_red.h2_max, params_.hsv_red.s_max, params_.hsv_red.v_max),
-                   mask2);
-        
-        cv::bitwise_or(mask1, mask2, color_mask);
+    // 工作区按当前图像（或跟踪窗口）尺寸取视图，尺寸不变时不重新分配
+    cv::Mat color_mask = workBuffer(color_mask_buf_, rgb_img.size(), CV_8UC1);
+    
+    bool use_fused = false;
+#ifdef RM_FUSED_COLOR_MASK
+    use_fused = (rgb_img.type() == CV_8UC3);
+#endif
+    
+    if (use_fused) {
+        // 单次遍历直接生成掩码，结果与下方 cvtColor + inRange 逐位一致
+        if (params_.detect_color == RED) {
+            HsvRange ranges[2] = {
+                makeHsvRange(params_.hsv_red.h1_min, params_.hsv_red.h1_max,
+                             params_.hsv_red.s_min, params_.hsv_red.s_max,
+                             params_.hsv_red.v_min, params_.hsv_red.v_max),
+                makeHsvRange(params_.hsv_red.h2_min, params_.hsv_red.h2_max,
+                             params_.hsv_red.s_min, params_.hsv_red.s_max,
+                             params_.hsv_red.v_min, params_.hsv_red.v_max)
+            };
+            fusedColorMask(rgb_img, color_mask, ranges, 2);
+        } else {
+            HsvRange range = makeHsvRange(100, 130,
+                                          params_.hsv_red.s_min, params_.hsv_red.s_max,
+                                          params_.hsv_red.v_min, params_.hsv_red.v_max);
+            fusedColorMask(rgb_img, color_mask, &range, 1);
+        }
     } else {
-        cv::inRange(hsv_img,
-                   cv::Scalar(100, params_.hsv_red.s_min, params_.hsv_red.v_min),
-                   cv::Scalar(130, params_.hsv_red.s_max, params_.hsv_red.v_max),
-                   color_mask);
+        cv::Mat hsv_img = workBuffer(hsv_buf_, rgb_img.size(), rgb_img.type());
+        cv::cvtColor(rgb_img, hsv_img, cv::COLOR_BGR2HSV);
+        
+        if (params_.detect_color == RED) {
+            cv::Mat mask1 = workBuffer(range_buf_, rgb_img.size(), CV_8UC1);
+            cv::inRange(hsv_img, 
+                       cv::Scalar(params_.hsv_red.h1_min, params_.hsv_red.s_min, params_.hsv_red.v_min),
+                       cv::Scalar(params_.hsv_red.h1_max, params_.hsv_red.s_max, params_.hsv_red.v_max),
+                       mask1);
+            
+            cv::inRange(hsv_img,
+                       cv::Scalar(params_.hsv_red.h2_min, params_.hsv_red.s_min, params_.hsv_red.v_min),
+                       cv::Scalar(params_.hsv_red.h2_max, params_.hsv_red.s_max, params_.hsv_red.v_max),
+                       color_mask);
+            
+            cv::bitwise_or(mask1, color_mask, color_mask);
+        } else {
+            cv::inRange(hsv_img,
+                       cv::Scalar(100, params_.hsv_red.s_min, params_.hsv_red.v_min),
+                       cv::Scalar(130, params_.hsv_red.s_max, params_.hsv_red.v_max),
+                       color_mask);
+        }
     }
     
-    cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(3, 3));
-    cv::morphologyEx(color_mask, color_mask, cv::MORPH_CLOSE, kernel);
-    cv::morphologyEx(color_mask, color_mask, cv::MORPH_OPEN, kernel);
+    // 3x3 闭运算 + 开运算，结果与 morphologyEx 相同，但不在内部分配缓冲
+    cv::Mat morph_tmp = workBuffer(morph_buf_, rgb_img.size(), CV_8UC1);
+    morphCloseOpen3x3(color_mask, morph_tmp);
     
     return color_mask;
 }
 
-std::vector<Light> Detector::findLights(const cv::Mat& rgb_img, const cv::Mat& binary_img) {
-    std::vector<std::vector<cv::Point>> contours;
-    std::vector<cv::Vec4i> hierarchy;
-    
-    cv::findContours(binary_img.clone(), contours, hierarchy, 
-                     cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+cv::Mat Detector::workBuffer(cv::Mat& storage, const cv::Size& size, int type) {
+    // 只在需要更大尺寸或类型变化时重新分配，返回左上角 size 大小的视图
+    if (storage.empty() || storage.type() != type ||
+        storage.cols < size.width || storage.rows < size.height) {
+        int rows = std::max(size.height, storage.type() == type ? storage.rows : 0);
+        int cols = std::max(size.width, storage.type() == type ? storage.cols : 0);
+        storage.create(rows, cols, type);
+    }
+    return storage(cv::Rect(0, 0, size.width, size.height));
+}
+
+void Detector::findLights(const cv::Mat& rgb_img, const cv::Mat& binary_img,
+                          std::vector<Light>& valid_lights) {
+    // OpenCV 4 的 findContours 不再修改输入图像，不需要 clone；
+    // 轮廓容器复用上一帧的容量
+    std::vector<std::vector<cv::Point>>& contours = contours_;
+    cv::findContours(binary_img, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
     
     debug_info_.contours_found = contours.size();
-    std::vector<Light> valid_lights;
+    valid_lights.clear();
     
     for (size_t i = 0; i < contours.size(); ++i) {
         if (contours[i].size() < 5) continue;
@@ -123,7 +244,10 @@ std::vector<Light> Detector::findLights(const cv::Mat& rgb_img, const cv::Mat& b
         
         if (isValidLight(light)) {
             debug_info_.lights_found++;
-            light.color = determineColor(rgb_img, light);
+            auto color_start = Clock::now();
+            light.color = determineColor(rgb_img, binary_img, light);
+            debug_info_.color_time_ms += std::chrono::duration<double, std::milli>(
+                Clock::now() - color_start).count();
             
             if (light.color == params_.detect_color) {
                 valid_lights.push_back(light);
@@ -131,8 +255,6 @@ std::vector<Light> Detector::findLights(const cv::Mat& rgb_img, const cv::Mat& b
             }
         }
     }
-    
-    return valid_lights;
 }
 
 bool Detector::isValidLight(const Light& light) {
@@ -149,7 +271,7 @@ bool Detector::isValidLight(const Light& light) {
     return true;
 }
 
-int Detector::determineColor(const cv::Mat& rgb_img, const Light& light) {
+int Detector::determineColor(const cv::Mat& rgb_img, const cv::Mat& binary_img, const Light& light) {
     cv::Rect bbox = light.rect.boundingRect();
     bbox.x = std::max(0, bbox.x);
     bbox.y = std::max(0, bbox.y);
@@ -160,43 +282,24 @@ int Detector::determineColor(const cv::Mat& rgb_img, const Light& light) {
         return params_.detect_color;
     }
     
-    cv::Mat roi = rgb_img(bbox);
-    
     // 获取旋转矩形的四个顶点
     cv::Point2f vertices[4];
     light.rect.points(vertices);
     
-    // 将顶点转换为轮廓点向量
-    std::vector<cv::Point2f> contour;
-    for (int i = 0; i < 4; i++) {
-        contour.push_back(vertices[i]);
-    }
-    
-    long long sum_r = 0, sum_b = 0;
-    int pixel_count = 0;
-    
-    for (int y = 0; y < roi.rows; ++y) {
-        const cv::Vec3b* img_ptr = roi.ptr<cv::Vec3b>(y);
-        for (int x = 0; x < roi.cols; ++x) {
-            // 检查点是否在灯条轮廓内
-            cv::Point2f roi_point(x + bbox.x, y + bbox.y);
-            if (cv::pointPolygonTest(contour, roi_point, false) >= 0) {
-                sum_b += img_ptr[x][0];  // B通道
-                sum_r += img_ptr[x][2];  // R通道
-                pixel_count++;
-            }
-        }
-    }
+    // 扫描线光栅化一次，整段累加 B/R，像素取舍与逐像素 pointPolygonTest 相同
+    ColorVote vote = voteLightColor(rgb_img, vertices, bbox,
+                                    params_.light.color_vote_mask_only ? binary_img : cv::Mat());
     
-    if (pixel_count == 0) return params_.detect_color;
-    return (sum_r > sum_b) ? RED : BLUE;
+    if (vote.pixel_count == 0) return params_.detect_color;
+    return (vote.sum_r > vote.sum_b) ? RED : BLUE;
 }
 
-std::vector<Armor> Detector::matchLights(const std::vector<Light>& lights) {
-    std::vector<Armor> armors;
+void Detector::matchLights(const std::vector<Light>& lights, std::vector<Armor>& armors) {
+    armors.clear();
     
-    // 只考虑目标颜色的灯条
-    std::vector<Light> target_lights;
+    // 只考虑目标颜色的灯条（装甲板中的灯条下标指向该缓冲）
+    std::vector<Light>& target_lights = target_lights_;
+    target_lights.clear();
     for (const auto& light : lights) {
         if (light.color == params_.detect_color) {
             target_lights.push_back(light);
@@ -204,29 +307,74 @@ std::vector<Armor> Detector::matchLights(const std::vector<Light>& lights) {
     }
     
     if (target_lights.size() < 2) {
-        return armors;
+        return;
     }
     
-    // 对所有灯条进行配对
-    for (size_t i = 0; i < target_lights.size(); ++i) {
-        for (size_t j = i + 1; j < target_lights.size(); ++j) {
-            const Light& light1 = target_lights[i];
-            const Light& light2 = target_lights[j];
-            
-            // 检查配对是否有效
-            ArmorType type = isArmor(light1, light2);
-            if (type != ArmorType::INVALID) {
-                // 检查区域内是否有其他灯条
-                if (!containLight(light1, light2, target_lights)) {
-                    Armor armor(light1, light2);
-                    armor.type = type;
-                    armors.push_back(armor);
-                }
-            }
+    // 按中心x排序建立索引，配对只考虑x方向上可能满足距离约束的灯条
+    buildLightIndex(target_lights);
+    
+    // 装甲板要求 中心距 / 平均灯条长度 不超过 max_distance，
+    // 另一根灯条的长度受全局最大长度和长度比约束，由此得到x方向的搜索半径
+    float max_distance = std::min(std::max(params_.armor.max_small_distance,
+                                           params_.armor.max_large_distance),
+                                  params_.armor.max_aspect_ratio);
+    float max_length = 0.0f;
+    for (const auto& light : target_lights) {
+        max_length = std::max(max_length, light.length);
+    }
+    
+    light_pairs_.clear();
+    for (size_t a = 0; a < light_order_.size(); ++a) {
+        const Light& light = target_lights[light_order_[a]];
+        float partner_length = max_length;
+        if (params_.armor.min_light_ratio > 0.0f) {
+            partner_length = std::min(partner_length, light.length / params_.armor.min_light_ratio);
+        }
+        // 留出浮点误差余量，保证不会漏掉原先能配对的灯条
+        float reach = max_distance * (light.length + partner_length) * 0.5f * 1.001f + 1.0f;
+        
+        for (size_t b = a + 1; b < light_order_.size() && light_xs_[b] - light_xs_[a] <= reach; ++b) {
+            int i = light_order_[a], j = light_order_[b];
+            light_pairs_.emplace_back(std::min(i, j), std::max(i, j));
         }
     }
     
-    return armors;
+    // 按原下标顺序检查候选对，输出顺序与两两枚举时一致
+    std::sort(light_pairs_.begin(), light_pairs_.end());
+    for (const auto& pair : light_pairs_) {
+        const Light& light1 = target_lights[pair.first];
+        const Light& light2 = target_lights[pair.second];
+        
+        // 检查配对是否有效
+        ArmorType type = isArmor(light1, light2);
+        if (type != ArmorType::INVALID) {
+            // 检查区域内是否有其他灯条
+            if (!containLight(pair.first, pair.second, target_lights)) {
+                Armor armor(light1, light2, pair.first, pair.second);
+                armor.type = type;
+                armors.push_back(armor);
+            }
+        }
+    }
+}
+
+void Detector::buildLightIndex(const std::vector<Light>& lights) {
+    light_order_.resize(lights.size());
+    for (size_t i = 0; i < lights.size(); ++i) {
+        light_order_[i] = static_cast<int>(i);
+    }
+    std::sort(light_order_.begin(), light_order_.end(), [&lights](int a, int b) {
+        return lights[a].center.x < lights[b].center.x;
+    });
+    
+    light_xs_.resize(lights.size());
+    light_extent_ = 0.0f;
+    for (size_t k = 0; k < light_order_.size(); ++k) {
+        const Light& light = lights[light_order_[k]];
+        light_xs_[k] = light.center.x;
+        light_extent_ = std::max(light_extent_, std::abs(light.top.x - light.center.x));
+        light_extent_ = std::max(light_extent_, std::abs(light.bottom.x - light.center.x));
+    }
 }
 
 ArmorType Detector::isArmor(const Light& light1, const Light& light2) {
@@ -280,13 +428,15 @@ ArmorType Detector::isArmor(const Light& light1, const Light& light2) {
     return type;
 }
 
-bool Detector::containLight(const Light& light1, const Light& light2, 
-                           const std::vector<Light>& lights) {
-    // 获取两个灯条形成的包围矩形
-    std::vector<cv::Point2f> points = {
+bool Detector::containLight(int i, int j, const std::vector<Light>& lights) {
+    const Light& light1 = lights[i];
+    const Light& light2 = lights[j];
+    
+    // 获取两个灯条形成的包围矩形（栈上数组包装成 Mat，不分配内存）
+    cv::Point2f points[4] = {
         light1.top, light1.bottom, light2.top, light2.bottom
     };
-    cv::Rect bbox = cv::boundingRect(points);
+    cv::Rect bbox = cv::boundingRect(cv::Mat(4, 1, CV_32FC2, points));
     
     // 扩展边界
     bbox.x -= 5;
@@ -294,12 +444,18 @@ bool Detector::containLight(const Light& light1, const Light& light2,
     bbox.width += 10;
     bbox.height += 10;
     
-    // 检查其他灯条是否在区域内
-    for (const auto& light : lights) {
-        if (&light == &light1 || &light == &light2) {
+    // 只检查中心x落在包围矩形附近的灯条：
+    // top/bottom 与中心的x偏移不超过 light_extent_，contains 会把坐标取整，再留1像素
+    float x_lo = bbox.x - light_extent_ - 1.0f;
+    float x_hi = bbox.x + bbox.width + light_extent_ + 1.0f;
+    size_t k = std::lower_bound(light_xs_.begin(), light_xs_.end(), x_lo) - light_xs_.begin();
+    for (; k < light_xs_.size() && light_xs_[k] <= x_hi; ++k) {
+        int idx = light_order_[k];
+        if (idx == i || idx == j) {
             continue;
         }
         
+        const Light& light = lights[idx];
         if (bbox.contains(light.center) ||
             bbox.contains(light.top) ||
             bbox.contains(light.bottom)) {
@@ -0,0 +1,117 @@
+#include "armor_detector/frame_arena.hpp"
+
+namespace rm_auto_aim {
+
+FrameHandle::FrameHandle(const FrameHandle& other)
+    : arena_(other.arena_), slot_(other.slot_) {
+    if (slot_) {
+        slot_->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+FrameHandle::FrameHandle(FrameHandle&& other) noexcept
+    : arena_(other.arena_), slot_(other.slot_) {
+    other.arena_ = nullptr;
+    other.slot_ = nullptr;
+}
+
+FrameHandle& FrameHandle::operator=(const FrameHandle& other) {
+    if (this != &other) {
+        if (other.slot_) {
+            other.slot_->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+        release();
+        arena_ = other.arena_;
+        slot_ = other.slot_;
+    }
+    return *this;
+}
+
+FrameHandle& FrameHandle::operator=(FrameHandle&& other) noexcept {
+    if (this != &other) {
+        release();
+        arena_ = other.arena_;
+        slot_ = other.slot_;
+        other.arena_ = nullptr;
+        other.slot_ = nullptr;
+    }
+    return *this;
+}
+
+void FrameHandle::release() {
+    if (!slot_) return;
+
+    // acq_rel 保证其他线程对帧的读取都发生在回收之前
+    if (slot_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        arena_->recycle(slot_);
+    }
+    arena_ = nullptr;
+    slot_ = nullptr;
+}
+
+const DetectionFrame* FrameHandle::get() const {
+    return slot_ ? &slot_->frame : nullptr;
+}
+
+DetectionFrame* FrameHandle::edit() {
+    return slot_ ? &slot_->frame : nullptr;
+}
+
+FrameArena::FrameArena(std::size_t initial_frames,
+                       std::size_t light_capacity,
+                       std::size_t armor_capacity)
+    : light_capacity_(light_capacity), armor_capacity_(armor_capacity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    slots_.reserve(initial_frames);
+    free_.reserve(initial_frames);
+    for (std::size_t i = 0; i < initial_frames; ++i) {
+        free_.push_back(createSlot());
+    }
+}
+
+FrameArena::~FrameArena() = default;
+
+FrameHandle::Slot* FrameArena::createSlot() {
+    // 调用方持有 mutex_
+    std::unique_ptr<FrameHandle::Slot> slot(new FrameHandle::Slot());
+    slot->frame.lights.reserve(light_capacity_);
+    slot->frame.armors.reserve(armor_capacity_);
+    slots_.push_back(std::move(slot));
+    // free_ 的容量不小于帧槽总数，回收时 push_back 不会分配
+    free_.reserve(slots_.size());
+    return slots_.back().get();
+}
+
+FrameHandle FrameArena::acquire() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    FrameHandle::Slot* slot = nullptr;
+    if (free_.empty()) {
+        slot = createSlot();
+    } else {
+        slot = free_.back();
+        free_.pop_back();
+    }
+
+    slot->frame.clear();
+    slot->frame.frame_id = next_frame_id_++;
+    slot->refs.store(1, std::memory_order_relaxed);
+    return FrameHandle(this, slot);
+}
+
+void FrameArena::recycle(FrameHandle::Slot* slot) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_.push_back(slot);
+}
+
+std::size_t FrameArena::capacity() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return slots_.size();
+}
+
+std::size_t FrameArena::inUse() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return slots_.size() - free_.size();
+}
+
+} // namespace rm_auto_aim
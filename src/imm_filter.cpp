@@ -0,0 +1,74 @@
+#include <algorithm>
+#include "armor_detector/imm_filter.hpp"
+
+namespace rm_auto_aim
+{
+
+ImmKalmanFilter::ImmKalmanFilter(const ImmNoiseParams& params)
+  : imm_({MotionModel::CONSTANT_VELOCITY, MotionModel::CONSTANT_ACCELERATION, MotionModel::STATIONARY},
+         params)
+{
+}
+
+void ImmKalmanFilter::init(const cv::Point2f& initial_pos, double timestamp)
+{
+  imm_.init(initial_pos);
+  initialized_ = true;
+  last_timestamp_ = timestamp;
+}
+
+cv::Point2f ImmKalmanFilter::predict(double timestamp)
+{
+  if (!initialized_) return cv::Point2f(0, 0);
+
+  // 时间戳未知或倒退时使用标称间隔
+  float dt = nominalDt_;
+  if (last_timestamp_ >= 0.0 && timestamp > last_timestamp_) {
+    dt = std::min(std::max(static_cast<float>(timestamp - last_timestamp_), minDt_), maxDt_);
+  }
+  if (timestamp >= 0.0) {
+    last_timestamp_ = timestamp;
+  }
+
+  dt_ = dt;
+  imm_.predict(dt);
+  return getPrediction();
+}
+
+void ImmKalmanFilter::update(const cv::Point2f& measurement)
+{
+  if (!initialized_) return;
+
+  imm_.update(measurement);
+}
+
+cv::Point2f ImmKalmanFilter::predictAt(double timestamp) const
+{
+  if (!initialized_) return cv::Point2f(0, 0);
+
+  double dt = 0.0;
+  if (last_timestamp_ >= 0.0 && timestamp >= 0.0) {
+    dt = std::min(timestamp - last_timestamp_, static_cast<double>(maxDt_));
+  }
+
+  // 组合状态中的加速度已按模型概率加权（匀速、静止模型的加速度为 0）
+  const auto& x = imm_.state();
+  return cv::Point2f(static_cast<float>(x[0] + x[1] * dt + 0.5 * x[2] * dt * dt),
+                     static_cast<float>(x[3] + x[4] * dt + 0.5 * x[5] * dt * dt));
+}
+
+cv::Point2f ImmKalmanFilter::getPrediction() const
+{
+  const auto& x = imm_.state();
+  return cv::Point2f(x[0], x[3]);
+}
+
+cv::Point2f ImmKalmanFilter::getVelocity() const
+{
+  if (!initialized_) return cv::Point2f(0, 0);
+
+  const auto& x = imm_.state();
+  return cv::Point2f(x[1], x[4]);
+}
+
+}  // namespace rm_auto_aim
@@ -0,0 +1,322 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include "armor_detector/imu_pose_buffer.hpp"
+
+namespace rm_auto_aim {
+
+Quaternion Quaternion::fromEuler(double yaw, double pitch, double roll) {
+    const double cy = std::cos(yaw * 0.5), sy = std::sin(yaw * 0.5);
+    const double cp = std::cos(pitch * 0.5), sp = std::sin(pitch * 0.5);
+    const double cr = std::cos(roll * 0.5), sr = std::sin(roll * 0.5);
+    return Quaternion(cy * cp * cr + sy * sp * sr,
+                      cy * cp * sr - sy * sp * cr,
+                      cy * sp * cr + sy * cp * sr,
+                      sy * cp * cr - cy * sp * sr);
+}
+
+Quaternion Quaternion::slerp(const Quaternion& a, const Quaternion& b, double ratio) {
+    // q 与 -q 表示同一姿态，取与 a 同半球的 b 走短弧
+    double dot = a.w * b.w + a.x * b.x + a.y * b.y + a.z * b.z;
+    const double sign = dot < 0.0 ? -1.0 : 1.0;
+    dot *= sign;
+
+    double wa, wb;
+    if (dot > 0.9995) {
+        // 夹角很小时 sin(theta) 接近 0，退化为线性插值再归一化
+        wa = 1.0 - ratio;
+        wb = ratio;
+    } else {
+        const double theta = std::acos(std::min(dot, 1.0));
+        const double inv_sin = 1.0 / std::sin(theta);
+        wa = std::sin((1.0 - ratio) * theta) * inv_sin;
+        wb = std::sin(ratio * theta) * inv_sin;
+    }
+    wb *= sign;
+    return Quaternion(wa * a.w + wb * b.w, wa * a.x + wb * b.x,
+                      wa * a.y + wb * b.y, wa * a.z + wb * b.z).normalized();
+}
+
+Quaternion Quaternion::normalized() const {
+    const double n = std::sqrt(w * w + x * x + y * y + z * z);
+    if (!(n > 1e-12)) {
+        return Quaternion();
+    }
+    return Quaternion(w / n, x / n, y / n, z / n);
+}
+
+Quaternion Quaternion::operator*(const Quaternion& o) const {
+    return Quaternion(w * o.w - x * o.x - y * o.y - z * o.z,
+                      w * o.x + x * o.w + y * o.z - z * o.y,
+                      w * o.y - x * o.z + y * o.w + z * o.x,
+                      w * o.z + x * o.y - y * o.x + z * o.w);
+}
+
+cv::Matx33d Quaternion::toRotationMatrix() const {
+    const double xx = x * x, yy = y * y, zz = z * z;
+    const double xy = x * y, xz = x * z, yz = y * z;
+    const double wx = w * x, wy = w * y, wz = w * z;
+    return cv::Matx33d(1.0 - 2.0 * (yy + zz), 2.0 * (xy - wz), 2.0 * (xz + wy),
+                       2.0 * (xy + wz), 1.0 - 2.0 * (xx + zz), 2.0 * (yz - wx),
+                       2.0 * (xz - wy), 2.0 * (yz + wx), 1.0 - 2.0 * (xx + yy));
+}
+
+RigidTransform RigidTransform::operator*(const RigidTransform& other) const {
+    RigidTransform result;
+    result.rotation = rotation * other.rotation;
+    result.translation = rotation * other.translation + translation;
+    return result;
+}
+
+void RigidTransform::transformPose(const cv::Vec3d& rvec, const cv::Vec3d& tvec,
+                                   cv::Vec3d& out_rvec, cv::Vec3d& out_tvec) const {
+    cv::Matx33d object_rotation;
+    cv::Rodrigues(rvec, object_rotation);
+    cv::Rodrigues(rotation * object_rotation, out_rvec);
+    out_tvec = apply(tvec);
+}
+
+RigidTransform CameraMount::opticalToGimbal() {
+    // 云台 x = 光学 z，云台 y = -光学 x，云台 z = -光学 y
+    RigidTransform transform;
+    transform.rotation = cv::Matx33d(0.0, 0.0, 1.0,
+                                     -1.0, 0.0, 0.0,
+                                     0.0, -1.0, 0.0);
+    return transform;
+}
+
+ImuPoseBuffer::ImuPoseBuffer(std::size_t capacity) {
+    capacity_ = 1;
+    while (capacity_ < std::max<std::size_t>(capacity, 2 * overwrite_guard_)) {
+        capacity_ <<= 1;
+    }
+    mask_ = capacity_ - 1;
+    slots_.reset(new Slot[capacity_]);
+}
+
+bool ImuPoseBuffer::push(const ImuSample& sample) {
+    const std::uint64_t index = count_.load(std::memory_order_relaxed);
+    if (index > 0 && !(sample.timestamp > last_timestamp_)) {
+        return false;
+    }
+    last_timestamp_ = sample.timestamp;
+
+    const Quaternion q = sample.orientation.normalized();
+    Slot& slot = slots_[index & mask_];
+    // 奇数序号表示写入中；release 栅栏保证读线程先看到奇数序号再看到新数据
+    slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.timestamp.store(sample.timestamp, std::memory_order_relaxed);
+    slot.w.store(q.w, std::memory_order_relaxed);
+    slot.x.store(q.x, std::memory_order_relaxed);
+    slot.y.store(q.y, std::memory_order_relaxed);
+    slot.z.store(q.z, std::memory_order_relaxed);
+    slot.sequence.store(2 * index + 2, std::memory_order_release);
+
+    count_.store(index + 1, std::memory_order_release);
+    return true;
+}
+
+bool ImuPoseBuffer::readTimestamp(std::uint64_t index, double& timestamp) const {
+    const Slot& slot = slots_[index & mask_];
+    const std::uint64_t expected = 2 * index + 2;
+    if (slot.sequence.load(std::memory_order_acquire) != expected) {
+        return false;
+    }
+    timestamp = slot.timestamp.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot.sequence.load(std::memory_order_relaxed) == expected;
+}
+
+bool ImuPoseBuffer::read(std::uint64_t index, ImuSample& sample) const {
+    const Slot& slot = slots_[index & mask_];
+    const std::uint64_t expected = 2 * index + 2;
+    if (slot.sequence.load(std::memory_order_acquire) != expected) {
+        return false;
+    }
+    sample.timestamp = slot.timestamp.load(std::memory_order_relaxed);
+    sample.orientation = Quaternion(slot.w.load(std::memory_order_relaxed), slot.x.load(std::memory_order_relaxed),
+                                    slot.y.load(std::memory_order_relaxed), slot.z.load(std::memory_order_relaxed));
+    // 读取期间槽位未被改写，数据才有效
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot.sequence.load(std::memory_order_relaxed) == expected;
+}
+
+bool ImuPoseBuffer::lookup(double timestamp, Quaternion& orientation) const {
+    const std::uint64_t count = count_.load(std::memory_order_acquire);
+    if (count == 0) {
+        return false;
+    }
+
+    const std::uint64_t newest = count - 1;
+    ImuSample after;
+    if (!read(newest, after)) {
+        return false;
+    }
+    if (timestamp >= after.timestamp) {
+        if (timestamp - after.timestamp > max_extrapolation_) {
+            return false;
+        }
+        // 最新采样之后：沿最后两个采样的角速度外推
+        ImuSample before;
+        if (newest == 0 || !read(newest - 1, before) || !(after.timestamp > before.timestamp)) {
+            orientation = after.orientation;
+            return true;
+        }
+        const double ratio = (timestamp - before.timestamp) / (after.timestamp - before.timestamp);
+        orientation = Quaternion::slerp(before.orientation, after.orientation, ratio);
+        return true;
+    }
+
+    // 二分查找满足 t[lo] <= timestamp < t[hi] 的相邻采样。
+    // 下界让出几个槽位给写线程；读取失败说明查询期间该槽位已被覆盖，目标时刻已过期
+    std::uint64_t lo = count > capacity_ - overwrite_guard_ ? count - (capacity_ - overwrite_guard_) : 0;
+    std::uint64_t hi = newest;
+    double t_lo = 0.0;
+    if (lo >= hi || !readTimestamp(lo, t_lo) || timestamp < t_lo) {
+        return false;
+    }
+    while (hi - lo > 1) {
+        const std::uint64_t mid = lo + (hi - lo) / 2;
+        double t_mid = 0.0;
+        if (!readTimestamp(mid, t_mid)) {
+            return false;
+        }
+        if (t_mid <= timestamp) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    ImuSample before;
+    if (!read(lo, before) || !read(hi, after) || !(after.timestamp > before.timestamp)) {
+        return false;
+    }
+    const double ratio = (timestamp - before.timestamp) / (after.timestamp - before.timestamp);
+    orientation = Quaternion::slerp(before.orientation, after.orientation, ratio);
+    return true;
+}
+
+bool ImuPoseBuffer::cameraToWorld(double timestamp, const CameraMount& mount, RigidTransform& transform) const {
+    Quaternion orientation;
+    if (!lookup(timestamp + mount.time_offset, orientation)) {
+        return false;
+    }
+    RigidTransform gimbal_to_world;
+    gimbal_to_world.rotation = orientation.toRotationMatrix();
+    transform = gimbal_to_world * mount.camera_to_gimbal;
+    return true;
+}
+
+bool ImuPoseBuffer::latest(ImuSample& sample) const {
+    const std::uint64_t count = count_.load(std::memory_order_acquire);
+    return count > 0 && read(count - 1, sample);
+}
+
+std::size_t ImuPoseBuffer::size() const {
+    return static_cast<std::size_t>(std::min<std::uint64_t>(count_.load(std::memory_order_acquire), capacity_));
+}
+
+void ImuPoseBuffer::clear() {
+    // 只能在写线程或没有写线程时调用；序号随 count_ 重新计数，旧槽位的序号不会被误认为有效
+    for (std::size_t i = 0; i < capacity_; ++i) {
+        slots_[i].sequence.store(0, std::memory_order_relaxed);
+    }
+    last_timestamp_ = 0.0;
+    count_.store(0, std::memory_order_release);
+}
+
+ImuReplaySource::~ImuReplaySource() {
+    stop();
+}
+
+bool ImuReplaySource::load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "[ERROR] Cannot open IMU log: " << path << std::endl;
+        return false;
+    }
+
+    samples_.clear();
+    std::string line;
+    int skipped = 0;
+    while (std::getline(file, line)) {
+        const std::size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') continue;
+
+        std::istringstream fields(line);
+        double values[5];
+        int n = 0;
+        while (n < 5 && fields >> values[n]) ++n;
+
+        ImuSample sample;
+        sample.timestamp = values[0];
+        if (n == 5) {
+            sample.orientation = Quaternion(values[1], values[2], values[3], values[4]).normalized();
+        } else if (n == 4) {
+            sample.orientation = Quaternion::fromEuler(values[1], values[2], values[3]);
+        } else {
+            skipped++;
+            continue;
+        }
+        if (!samples_.empty() && !(sample.timestamp > samples_.back().timestamp)) {
+            skipped++;
+            continue;
+        }
+        samples_.push_back(sample);
+    }
+
+    if (skipped > 0) {
+        std::cerr << "[WARNING] Skipped " << skipped << " malformed or out-of-order IMU samples" << std::endl;
+    }
+    std::cout << "[IMU] Loaded " << samples_.size() << " samples (" << duration() << " s) from " << path << std::endl;
+    return !samples_.empty();
+}
+
+double ImuReplaySource::duration() const {
+    return samples_.size() < 2 ? 0.0 : samples_.back().timestamp - samples_.front().timestamp;
+}
+
+bool ImuReplaySource::start(ImuPoseBuffer& buffer, double time_base, bool realtime) {
+    if (running_.load() || samples_.empty()) {
+        return false;
+    }
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    running_ = true;
+    thread_ = std::thread(&ImuReplaySource::run, this, &buffer, time_base, realtime);
+    return true;
+}
+
+void ImuReplaySource::stop() {
+    running_ = false;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void ImuReplaySource::run(ImuPoseBuffer* buffer, double time_base, bool realtime) {
+    using Clock = std::chrono::steady_clock;
+    const Clock::time_point start = Clock::now();
+    const double t0 = samples_.front().timestamp;
+
+    for (const ImuSample& sample : samples_) {
+        if (!running_.load(std::memory_order_acquire)) break;
+
+        const double elapsed = sample.timestamp - t0;
+        if (realtime) {
+            std::this_thread::sleep_until(start + std::chrono::duration_cast<Clock::duration>(
+                                                      std::chrono::duration<double>(elapsed)));
+        }
+        buffer->push(time_base + elapsed, sample.orientation);
+    }
+
+    running_.store(false, std::memory_order_release);
+}
+
+} // namespace rm_auto_aim
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cmath>
 #include "armor_detector/kalman_filter.hpp"
 
@@ -5,74 +6,137 @@ namespace rm_auto_aim
 {
 
 KalmanFilter::KalmanFilter()
-  : kf_(stateSize_, measSize_, contrSize_, CV_32F),
-    initialized_(false)
+  : initialized_(false)
 {
   initKalmanFilter();
 }
 
 void KalmanFilter::initKalmanFilter()
 {
+  using Filter = FixedKalmanFilter<stateSize_, measSize_>;
+  
   // 状态转移矩阵 A (x, vx, y, vy)
-  cv::setIdentity(kf_.transitionMatrix);
-  kf_.transitionMatrix.at<float>(0, 1) = 0.033f;  // dt = 0.033s (30fps)
-  kf_.transitionMatrix.at<float>(2, 3) = 0.033f;
+  kf_.transitionMatrix = Filter::StateMatrix::identity();
   
   // 测量矩阵 H (只测量位置)
-  kf_.measurementMatrix = cv::Mat::zeros(measSize_, stateSize_, CV_32F);
-  kf_.measurementMatrix.at<float>(0, 0) = 1.0f;
-  kf_.measurementMatrix.at<float>(1, 2) = 1.0f;
+  kf_.measurementMatrix = Filter::MeasMatrix::zeros();
+  kf_.measurementMatrix(0, 0) = 1.0f;
+  kf_.measurementMatrix(1, 2) = 1.0f;
   
   // 过程噪声协方差矩阵 Q
-  kf_.processNoiseCov = cv::Mat::eye(stateSize_, stateSize_, CV_32F) * 0.001f;
-  kf_.processNoiseCov.at<float>(0, 0) = 0.1f;
-  kf_.processNoiseCov.at<float>(1, 1) = 0.5f;
-  kf_.processNoiseCov.at<float>(2, 2) = 0.1f;
-  kf_.processNoiseCov.at<float>(3, 3) = 0.5f;
+  kf_.processNoiseCov = Filter::StateMatrix::identity(0.001f);
+  
+  // A 与 Q 中随 dt 变化的部分
+  setTransition(dt_);
   
   // 测量噪声协方差矩阵 R
-  kf_.measurementNoiseCov = cv::Mat::eye(measSize_, measSize_, CV_32F) * 5.0f;
+  kf_.measurementNoiseCov = Filter::MeasCovMatrix::identity(5.0f);
   
   // 后验误差协方差矩阵 P
-  cv::setIdentity(kf_.errorCovPost, cv::Scalar::all(0.1));
+  kf_.errorCovPost = Filter::StateMatrix::identity(0.1f);
   
   // 初始化测量向量
-  measurement_ = cv::Mat::zeros(measSize_, 1, CV_32F);
+  measurement_ = Filter::MeasVector::zeros();
 }
 
-void KalmanFilter::init(const cv::Point2f& initial_pos)
+void KalmanFilter::setTransition(float dt)
 {
-  kf_.statePost.at<float>(0) = initial_pos.x;  // x
-  kf_.statePost.at<float>(1) = 0.0f;          // vx
-  kf_.statePost.at<float>(2) = initial_pos.y;  // y
-  kf_.statePost.at<float>(3) = 0.0f;          // vy
+  dt_ = dt;
+  kf_.transitionMatrix(0, 1) = dt;
+  kf_.transitionMatrix(2, 3) = dt;
+  
+  const float scale = dt / nominalDt_;
+  kf_.processNoiseCov(0, 0) = 0.1f * scale;
+  kf_.processNoiseCov(1, 1) = 0.5f * scale;
+  kf_.processNoiseCov(2, 2) = 0.1f * scale;
+  kf_.processNoiseCov(3, 3) = 0.5f * scale;
+}
+
+void KalmanFilter::init(const cv::Point2f& initial_pos, double timestamp)
+{
+  kf_.statePost[0] = initial_pos.x;  // x
+  kf_.statePost[1] = 0.0f;           // vx
+  kf_.statePost[2] = initial_pos.y;  // y
+  kf_.statePost[3] = 0.0f;           // vy
+  kf_.errorCovPost = FixedKalmanFilter<stateSize_, measSize_>::StateMatrix::identity(0.1f);
+  // correct 以先验为基准：未经 predict 直接 update 时也要有有效的先验
+  kf_.statePre = kf_.statePost;
+  kf_.errorCovPre = kf_.errorCovPost;
   
   initialized_ = true;
   prediction_ = initial_pos;
+  last_timestamp_ = timestamp;
 }
 
 cv::Point2f KalmanFilter::predict()
 {
   if (!initialized_) return cv::Point2f(0, 0);
   
-  cv::Mat prediction = kf_.predict();
-  prediction_.x = prediction.at<float>(0);
-  prediction_.y = prediction.at<float>(2);
+  const auto& prediction = kf_.predict();
+  prediction_.x = prediction[0];
+  prediction_.y = prediction[2];
   
   return prediction_;
 }
 
+cv::Point2f KalmanFilter::predict(double timestamp)
+{
+  if (!initialized_) return cv::Point2f(0, 0);
+  
+  // 时间戳未知或倒退时使用标称间隔
+  float dt = nominalDt_;
+  if (last_timestamp_ >= 0.0 && timestamp > last_timestamp_) {
+    dt = std::min(std::max(static_cast<float>(timestamp - last_timestamp_), minDt_), maxDt_);
+  }
+  if (timestamp >= 0.0) {
+    last_timestamp_ = timestamp;
+  }
+  
+  if (dt != dt_) {
+    setTransition(dt);
+  }
+  return predict();
+}
+
+cv::Point2f KalmanFilter::predictAt(double timestamp) const
+{
+  if (!initialized_) return cv::Point2f(0, 0);
+  
+  double dt = 0.0;
+  if (last_timestamp_ >= 0.0 && timestamp >= 0.0) {
+    dt = timestamp - last_timestamp_;
+  }
+  return cv::Point2f(static_cast<float>(kf_.statePost[0] + kf_.statePost[1] * dt),
+                     static_cast<float>(kf_.statePost[2] + kf_.statePost[3] * dt));
+}
+
 void KalmanFilter::update(const cv::Point2f& measurement)
 {
   if (!initialized_) return;
   
-  measurement_.at<float>(0) = measurement.x;
-  measurement_.at<float>(1) = measurement.y;
+  measurement_[0] = measurement.x;
+  measurement_[1] = measurement.y;
   
   kf_.correct(measurement_);
   
-  prediction_.x = kf_.statePost.at<float>(0);
-  prediction_.y = kf_.statePost.at<float>(2);
+  prediction_.x = kf_.statePost[0];
+  prediction_.y = kf_.statePost[2];
+}
+
+cv::Point2f KalmanFilter::getVelocity() const
+{
+  if (!initialized_) return cv::Point2f(0, 0);
+  
+  return cv::Point2f(kf_.statePost[1], kf_.statePost[3]);
+}
+
+cv::Matx22f KalmanFilter::getInnovationCov() const
+{
+  // H 只取 x、y 两个位置分量；predict 后 errorCovPost 与 errorCovPre 相同
+  const auto& P = kf_.errorCovPost;
+  const auto& R = kf_.measurementNoiseCov;
+  return cv::Matx22f(P(0, 0) + R(0, 0), P(0, 2) + R(0, 1),
+                     P(2, 0) + R(1, 0), P(2, 2) + R(1, 1));
 }
 
 } // namespace rm_auto_aim
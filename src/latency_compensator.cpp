@@ -0,0 +1,52 @@
+#include <algorithm>
+#include "armor_detector/latency_compensator.hpp"
+
+namespace rm_auto_aim {
+
+LatencyCompensator::LatencyCompensator(double smoothing, double actuation_delay_s)
+    : smoothing_(std::min(std::max(smoothing, 0.0), 1.0)) {
+    actuation_delay_s_.store(actuation_delay_s, std::memory_order_relaxed);
+}
+
+void LatencyCompensator::addSample(double latency_s) {
+    if (latency_s < 0.0) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (latency_s <= max_sample_s_) {
+        // 第一个样本直接作为初值，避免从 0 缓慢爬升
+        const double previous = smoothed_s_.load(std::memory_order_relaxed);
+        const double smoothed = samples_ == 0 ? latency_s : previous + smoothing_ * (latency_s - previous);
+        smoothed_s_.store(smoothed, std::memory_order_relaxed);
+    }
+
+    min_s_ = samples_ == 0 ? latency_s : std::min(min_s_, latency_s);
+    max_s_ = samples_ == 0 ? latency_s : std::max(max_s_, latency_s);
+    last_s_ = latency_s;
+    sum_s_ += latency_s;
+    samples_++;
+}
+
+LatencyStats LatencyCompensator::getStats() const {
+    LatencyStats stats;
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats.samples = samples_;
+    stats.last_ms = last_s_ * 1e3;
+    stats.smoothed_ms = smoothed_s_.load(std::memory_order_relaxed) * 1e3;
+    stats.mean_ms = samples_ > 0 ? sum_s_ / samples_ * 1e3 : 0.0;
+    stats.min_ms = min_s_ * 1e3;
+    stats.max_ms = max_s_ * 1e3;
+    stats.actuation_delay_ms = getActuationDelay() * 1e3;
+    stats.lead_time_ms = getLeadTime() * 1e3;
+    return stats;
+}
+
+void LatencyCompensator::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    smoothed_s_.store(0.0, std::memory_order_relaxed);
+    samples_ = 0;
+    last_s_ = sum_s_ = min_s_ = max_s_ = 0.0;
+}
+
+} // namespace rm_auto_aim
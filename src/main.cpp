@@ -1,9 +1,19 @@
 #include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
 #include <opencv2/opencv.hpp>
 #include "armor_detector/detector.hpp"
 #include "armor_detector/tracker.hpp"
 #include "armor_detector/coordinate_transformer.hpp"
+#include "armor_detector/camera_calibrator.hpp"
+#include "armor_detector/imu_pose_buffer.hpp"
 #include "armor_detector/params_loader.hpp"
+#include "armor_detector/pipeline.hpp"
 
 using namespace rm_auto_aim;
 
@@ -24,13 +34,289 @@ void drawResults(cv::Mat& frame, const std::vector<Armor>& armors) {
     }
 }
 
+// 输入是否为视频文件或相机编号（否则运行单帧演示）
+bool isVideoInput(const std::string& input) {
+    if (!input.empty() && std::all_of(input.begin(), input.end(), ::isdigit)) {
+        return true;
+    }
+    std::string lower = input;
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    for (const char* ext : {".mp4", ".avi", ".mkv", ".mov"}) {
+        const std::string e(ext);
+        if (lower.size() >= e.size() && lower.compare(lower.size() - e.size(), e.size(), e) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool openCapture(cv::VideoCapture& cap, const std::string& input) {
+    if (std::all_of(input.begin(), input.end(), ::isdigit)) {
+        cap.open(std::stoi(input));
+    } else {
+        cap.open(input);
+    }
+    if (!cap.isOpened()) {
+        std::cerr << "[ERROR] Cannot open input: " << input << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// 读取一帧；视频文件使用文件内的时间戳，相机保留流水线预置的采集时钟
+bool readFrame(cv::VideoCapture& cap, const std::string& input, cv::Mat& frame, double& timestamp) {
+    if (!cap.read(frame)) {
+        return false;
+    }
+    if (!std::all_of(input.begin(), input.end(), ::isdigit)) {
+        timestamp = cap.get(cv::CAP_PROP_POS_MSEC) / 1000.0;
+    }
+    return true;
+}
+
+void setDummyCameraParams(Pipeline& pipeline, const cv::VideoCapture& cap) {
+    cv::Mat camera_matrix, dist_coeffs;
+    CameraCalibrator::generateDummyCameraParams(camera_matrix, dist_coeffs,
+                                                static_cast<int>(cap.get(cv::CAP_PROP_FRAME_WIDTH)),
+                                                static_cast<int>(cap.get(cv::CAP_PROP_FRAME_HEIGHT)));
+    pipeline.setCameraParams(camera_matrix, dist_coeffs);
+}
+
+// 回放 IMU 日志代替电控串口。相机输入按记录的节奏实时写入，时间戳对齐到流水线的单调时钟；
+// 视频文件的帧时间戳从 0 开始，日志一次写完，缓冲容量覆盖整个日志
+bool startImuReplay(const std::string& imu_file, const std::string& input, Pipeline& pipeline,
+                    ImuReplaySource& replay, std::unique_ptr<ImuPoseBuffer>& buffer) {
+    if (imu_file.empty()) {
+        return true;
+    }
+    if (!replay.load(imu_file)) {
+        return false;
+    }
+    
+    const bool camera = std::all_of(input.begin(), input.end(), ::isdigit);
+    buffer.reset(new ImuPoseBuffer(camera ? 2048 : replay.size()));
+    const double time_base = camera
+        ? std::chrono::duration<double>(PipelineFrame::Clock::now().time_since_epoch()).count()
+        : 0.0;
+    replay.start(*buffer, time_base, camera);
+    pipeline.setImuBuffer(buffer.get());
+    return true;
+}
+
+// 视频/相机输入：采集、检测、跟踪在各自线程运行，主线程负责显示
+int runVideoPipeline(const std::string& input, const std::string& imu_file, double actuation_delay_s,
+                     double bullet_speed) {
+    cv::VideoCapture cap;
+    if (!openCapture(cap, input)) {
+        return -1;
+    }
+    
+    PipelineConfig config;
+    config.actuation_delay_s = actuation_delay_s;
+    config.bullet_speed = bullet_speed;
+    // IMU 缓冲与回放须在流水线停止之后析构
+    std::unique_ptr<ImuPoseBuffer> imu_buffer;
+    ImuReplaySource imu_replay;
+    Pipeline pipeline(g_params, config);
+    setDummyCameraParams(pipeline, cap);
+    if (!startImuReplay(imu_file, input, pipeline, imu_replay, imu_buffer)) {
+        return -1;
+    }
+    
+    pipeline.start([&cap, &input](cv::Mat& frame, double& timestamp) {
+        return readFrame(cap, input, frame, timestamp);
+    });
+    
+    cv::Mat display;
+    pipeline.runOutput([&display](const PipelineFrame& frame) {
+        frame.image.copyTo(display);
+        drawResults(display, frame.detections->armors);
+        
+        if (frame.track.has_target) {
+            cv::circle(display, frame.track.predicted_position, 6, cv::Scalar(0, 255, 0), 2);
+            // 延迟补偿后的瞄准点
+            cv::drawMarker(display, frame.track.aim_position, cv::Scalar(0, 0, 255), cv::MARKER_CROSS, 14, 2);
+        }
+        if (frame.track.pnp_valid) {
+            cv::putText(display, cv::format("Distance: %.2f m", cv::norm(frame.track.tvec)),
+                       cv::Point(20, 30), cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(0, 255, 0), 2);
+            if (frame.track.imu_valid) {
+                cv::putText(display, cv::format("World: %.2f %.2f %.2f m", frame.track.world_tvec[0],
+                                                frame.track.world_tvec[1], frame.track.world_tvec[2]),
+                           cv::Point(260, 30), cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(0, 255, 0), 2);
+            }
+        }
+        if (frame.track.shot.valid) {
+            cv::putText(display, cv::format("Pitch %.2f Yaw %.2f deg, flight %.0f ms",
+                                            frame.track.shot.pitch * 180.0 / CV_PI,
+                                            frame.track.shot.yaw * 180.0 / CV_PI,
+                                            frame.track.shot.flight_time * 1000.0),
+                       cv::Point(20, 60), cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(0, 255, 0), 2);
+        }
+        if (frame.track.spinning) {
+            cv::putText(display, cv::format("Spin %.1f rad/s %s", frame.track.spin_rate,
+                                            frame.track.fire_allowed ? "FIRE" : "hold"),
+                       cv::Point(20, 90), cv::FONT_HERSHEY_SIMPLEX, 0.6,
+                       frame.track.fire_allowed ? cv::Scalar(0, 0, 255) : cv::Scalar(0, 255, 255), 2);
+        }
+        
+        cv::imshow("RoboMaster Vision - Pipeline", display);
+        int key = cv::waitKey(1);
+        return key != 27 && key != 'q';
+    });
+    
+    pipeline.printStats();
+    return 0;
+}
+
+// 作用域内把 std::cout 改写到 stderr，析构时恢复。
+// 无界面模式下 stdout 只留给检测记录，库内各处的日志（[INIT]、[TRACKER]、[IMU] 等）都改走 stderr
+class StdoutToStderr {
+public:
+    StdoutToStderr() : stdout_buf_(std::cout.rdbuf(std::cerr.rdbuf())) {}
+    ~StdoutToStderr() { std::cout.rdbuf(stdout_buf_); }
+
+    StdoutToStderr(const StdoutToStderr&) = delete;
+    StdoutToStderr& operator=(const StdoutToStderr&) = delete;
+
+    // 原来的 stdout 缓冲，用于写检测记录
+    std::streambuf* stdoutBuffer() const { return stdout_buf_; }
+
+private:
+    std::streambuf* stdout_buf_;
+};
+
+// 无界面模式：不调用 HighGUI、不绘制，检测结果以紧凑文本逐帧输出。
+// 每行：帧号 延迟ms 装甲板数 [类型(S/L) 中心x 中心y]... 跟踪状态 [x y z]
+// 视频文件逐帧处理以测得真实最大帧率；相机输入丢弃旧帧以保证延迟
+int runHeadless(const std::string& input, const std::string& output_file, const std::string& imu_file,
+                double actuation_delay_s, double bullet_speed) {
+    cv::VideoCapture cap;
+    if (!openCapture(cap, input)) {
+        return -1;
+    }
+    
+    std::ofstream file;
+    if (!output_file.empty()) {
+        file.open(output_file);
+        if (!file.is_open()) {
+            std::cerr << "[ERROR] Cannot create output file: " << output_file << std::endl;
+            return -1;
+        }
+    }
+    // 须在创建流水线之前生效，并在流水线与 IMU 回放线程结束之后才恢复
+    StdoutToStderr redirect;
+    std::ostream records(redirect.stdoutBuffer());
+    std::ostream& out = output_file.empty() ? records : file;
+    
+    DetectorParams params = g_params;
+    params.log_frames = false;
+    
+    PipelineConfig config;
+    config.drop_oldest = std::all_of(input.begin(), input.end(), ::isdigit);
+    config.queue_capacity = 4;
+    config.stats_out = &std::cerr;
+    config.actuation_delay_s = actuation_delay_s;
+    config.bullet_speed = bullet_speed;
+    
+    std::unique_ptr<ImuPoseBuffer> imu_buffer;
+    ImuReplaySource imu_replay;
+    Pipeline pipeline(params, config);
+    setDummyCameraParams(pipeline, cap);
+    if (!startImuReplay(imu_file, input, pipeline, imu_replay, imu_buffer)) {
+        return -1;
+    }
+    
+    pipeline.start([&cap, &input](cv::Mat& frame, double& timestamp) {
+        return readFrame(cap, input, frame, timestamp);
+    });
+    
+    out << "# frame latency_ms armors [type cx cy]... state [x y z]\n";
+    char line[64];
+    pipeline.runOutput([&out, &line](const PipelineFrame& frame) {
+        const double latency_ms = std::chrono::duration<double, std::milli>(
+            PipelineFrame::Clock::now() - frame.capture_time).count();
+        const auto& armors = frame.detections->armors;
+        
+        std::snprintf(line, sizeof(line), "%llu %.2f %zu",
+                      static_cast<unsigned long long>(frame.id), latency_ms, armors.size());
+        out << line;
+        for (const auto& armor : armors) {
+            std::snprintf(line, sizeof(line), " %c %.1f %.1f",
+                          armor.type == ArmorType::LARGE ? 'L' : 'S', armor.center.x, armor.center.y);
+            out << line;
+        }
+        out << ' ' << static_cast<int>(frame.track.state);
+        if (frame.track.pnp_valid) {
+            std::snprintf(line, sizeof(line), " %.3f %.3f %.3f",
+                          frame.track.tvec[0], frame.track.tvec[1], frame.track.tvec[2]);
+            out << line;
+        }
+        out << '\n';
+        return true;
+    });
+    
+    out.flush();
+    pipeline.printStats(std::cerr);
+    return 0;
+}
+
+void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [input] [--headless] [--output FILE] [--actuation-delay MS] [--bullet-speed M/S] [--imu FILE]" << std::endl;
+    std::cout << "  input          video file or camera index (default: synthetic demo frame)" << std::endl;
+    std::cout << "  --headless     no display; write detections as text (stdout by default)" << std::endl;
+    std::cout << "  --output FILE  write headless detections to FILE" << std::endl;
+    std::cout << "  --actuation-delay MS  extra delay after output (serial link, gimbal) added to the aim lead time" << std::endl;
+    std::cout << "  --bullet-speed M/S    muzzle speed for the ballistic solver (default 25)" << std::endl;
+    std::cout << "  --imu FILE     replay gimbal orientation log (lines: t qw qx qy qz, or t yaw pitch roll in rad)" << std::endl;
+}
+
 int main(int argc, char** argv) {
+    // 解析命令行
+    std::string input_file = "test.jpg";
+    std::string output_file;
+    std::string imu_file;
+    bool headless = false;
+    double actuation_delay_s = 0.0;
+    double bullet_speed = PipelineConfig().bullet_speed;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--headless") {
+            headless = true;
+        } else if ((arg == "--output" || arg == "-o") && i + 1 < argc) {
+            output_file = argv[++i];
+        } else if (arg == "--actuation-delay" && i + 1 < argc) {
+            actuation_delay_s = std::atof(argv[++i]) / 1000.0;
+        } else if (arg == "--bullet-speed" && i + 1 < argc) {
+            bullet_speed = std::atof(argv[++i]);
+        } else if (arg == "--imu" && i + 1 < argc) {
+            imu_file = argv[++i];
+        } else if (arg == "--help" || arg == "-h") {
+            printUsage(argv[0]);
+            return 0;
+        } else {
+            input_file = arg;
+        }
+    }
+    
+    // 使用默认参数
+    g_params = rm_auto_aim::createDefaultParams();
+    
+    if (headless) {
+        if (!isVideoInput(input_file)) {
+            std::cerr << "[ERROR] Headless mode needs a video file or camera index" << std::endl;
+            return -1;
+        }
+        return runHeadless(input_file, output_file, imu_file, actuation_delay_s, bullet_speed);
+    }
+    
     std::cout << "========================================" << std::endl;
     std::cout << "RoboMaster Vision - 2.2.1.4 Final" << std::endl;
     std::cout << "========================================" << std::endl;
     
-    // 使用默认参数
-    g_params = rm_auto_aim::createDefaultParams();
+    if (isVideoInput(input_file)) {
+        return runVideoPipeline(input_file, imu_file, actuation_delay_s, bullet_speed);
+    }
     
     // 创建检测器
     Detector detector(g_params);
@@ -38,12 +324,6 @@ int main(int argc, char** argv) {
     // 创建坐标转换器
     CoordinateTransformer transformer;
     
-    // 判断输入
-    std::string input_file = "test.jpg";
-    if (argc > 1) {
-        input_file = argv[1];
-    }
-    
     // 创建测试图片
     cv::Mat frame(480, 640, CV_8UC3, cv::Scalar(0, 0, 0));
     cv::rectangle(frame, cv::Rect(280,190,20,100), cv::Scalar(0,0,255), -1);
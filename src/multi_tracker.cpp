@@ -0,0 +1,263 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include "armor_detector/multi_tracker.hpp"
+
+namespace rm_auto_aim {
+
+MultiTracker::MultiTracker() : kf_(max_tracks_) {
+    tracks_.reserve(max_tracks_);
+    cold_tracks_.reserve(max_tracks_);
+    cold_armors_.reserve(max_tracks_);
+    cold_poses_.reserve(max_tracks_);
+    reset();
+}
+
+void MultiTracker::reset() {
+    tracks_.clear();
+    kf_.clear();
+    target_id_ = 0;
+    last_timestamp_ = -1.0;
+    last_dt_ = static_cast<float>(nominal_frame_interval_);
+}
+
+void MultiTracker::update(const std::vector<Armor>& armors, double timestamp) {
+    // 1. 按实际帧间隔批量预测所有轨迹
+    float dt = static_cast<float>(nominal_frame_interval_);
+    if (timestamp >= 0.0 && last_timestamp_ >= 0.0 && timestamp > last_timestamp_) {
+        dt = std::min(static_cast<float>(timestamp - last_timestamp_), max_dt_);
+    }
+    if (timestamp >= 0.0) {
+        last_timestamp_ = timestamp;
+    } else if (last_timestamp_ >= 0.0) {
+        last_timestamp_ += nominal_frame_interval_;
+    }
+    last_dt_ = dt;
+
+    kf_.predict(dt);
+    for (size_t i = 0; i < tracks_.size(); ++i) {
+        tracks_[i].predicted_position = kf_.position(static_cast<int>(i));
+        tracks_[i].detection = -1;
+    }
+
+    // 2. 全局分配，更新命中的轨迹
+    associate(armors);
+
+    // 3. 未命中的轨迹按状态机累计丢失，倒序遍历以便删除
+    for (int i = static_cast<int>(tracks_.size()) - 1; i >= 0; --i) {
+        Track& track = tracks_[i];
+        if (track_to_detection_[i] >= 0) continue;
+
+        if (track.state == Tracker::DETECTING) {
+            // 确认前丢失一次即放弃
+            removeTrack(i);
+            continue;
+        }
+
+        track.lost_count++;
+        if (track.lost_count >= lost_thres_ * 2) {
+            removeTrack(i);
+        } else if (track.lost_count >= lost_thres_) {
+            track.state = Tracker::TEMP_LOST;
+        }
+    }
+
+    // 4. 未分配的检测建立新轨迹
+    for (size_t j = 0; j < armors.size(); ++j) {
+        if (detection_matched_[j] || !armors[j].isValid() || tracks_.size() >= max_tracks_) continue;
+
+        Track track;
+        track.id = next_id_++;
+        track.state = Tracker::DETECTING;
+        track.armor = armors[j];
+        track.detection = static_cast<int>(j);
+        track.predicted_position = armors[j].center;
+        track.detect_count = 1;
+        tracks_.push_back(track);
+        kf_.add(armors[j].center);
+    }
+
+    selectTarget();
+}
+
+void MultiTracker::associate(const std::vector<Armor>& armors) {
+    const int rows = static_cast<int>(tracks_.size());
+    const int cols = static_cast<int>(armors.size());
+
+    track_to_detection_.assign(rows, -1);
+    detection_matched_.assign(cols, 0);
+    if (rows == 0 || cols == 0) {
+        return;
+    }
+
+    // 超出门限的组合给一个远大于门限的代价，分配后再剔除
+    const float infeasible = gate_chi2_ * 1000.0f;
+    const float motion = gate_motion_std_ * gate_motion_std_;
+    cost_.resize(static_cast<size_t>(rows) * cols);
+    for (int i = 0; i < rows; ++i) {
+        // 每条轨迹只求一次 S^-1
+        InnovationGate gate;
+        const cv::Point2f s = kf_.innovationVariance(i);
+        gate.set(s.x + motion, 0.0f, s.y + motion);
+
+        for (int j = 0; j < cols; ++j) {
+            float score = -1.0f;
+            if (armors[j].isValid()) {
+                score = Tracker::matchScore(tracks_[i].armor, tracks_[i].predicted_position, gate, gate_chi2_, armors[j]);
+            }
+            cost_[i * cols + j] = score >= 0.0f ? score : infeasible;
+        }
+    }
+
+    solver_.solve(cost_.data(), rows, cols, track_to_detection_);
+
+    for (int i = 0; i < rows; ++i) {
+        const int j = track_to_detection_[i];
+        if (j < 0) continue;
+        if (!(cost_[i * cols + j] < infeasible)) {
+            track_to_detection_[i] = -1;
+            continue;
+        }
+
+        Track& track = tracks_[i];
+        const Armor& armor = armors[j];
+        detection_matched_[j] = 1;
+
+        kf_.setMeasurement(i, armor.center);
+        track.armor = armor;
+        track.detection = j;
+        track.lost_count = 0;
+
+        if (track.state == Tracker::DETECTING) {
+            if (++track.detect_count >= tracking_thres_) {
+                track.state = Tracker::TRACKING;
+            }
+        } else {
+            track.state = Tracker::TRACKING;
+        }
+    }
+
+    // 所有命中的轨迹一次批量校正
+    kf_.update();
+    for (int i = 0; i < rows; ++i) {
+        if (track_to_detection_[i] >= 0) {
+            tracks_[i].predicted_position = kf_.position(i);
+        }
+    }
+}
+
+void MultiTracker::removeTrack(int index) {
+    // 与 BatchedKalmanFilter 一致：最后一条轨迹移到被删除的位置
+    const int last = static_cast<int>(tracks_.size()) - 1;
+    if (index != last) {
+        tracks_[index] = tracks_[last];
+        track_to_detection_[index] = track_to_detection_[last];
+    }
+    tracks_.pop_back();
+    track_to_detection_.pop_back();
+    kf_.remove(index);
+}
+
+void MultiTracker::selectTarget() {
+    // 原目标仍是已确认轨迹时保持不变
+    for (const auto& track : tracks_) {
+        if (track.id == target_id_ && track.isConfirmed()) {
+            return;
+        }
+    }
+
+    // 否则在已确认轨迹中选择：优先正在跟踪的，其次离图像中心最近的
+    const std::uint32_t previous = target_id_;
+    const Track* best = nullptr;
+    float best_distance = std::numeric_limits<float>::max();
+    for (const auto& track : tracks_) {
+        if (!track.isConfirmed()) continue;
+
+        float distance = cv::norm(track.predicted_position - image_center_);
+        if (track.state == Tracker::TEMP_LOST) {
+            distance += 1e6f;
+        }
+        if (distance < best_distance) {
+            best_distance = distance;
+            best = &track;
+        }
+    }
+
+    target_id_ = best ? best->id : 0;
+    if (target_id_ != previous && target_id_ != 0) {
+        std::cout << "[TRACKER] Target switched to track " << target_id_ << std::endl;
+    }
+}
+
+const Track* MultiTracker::getTarget() const {
+    for (const auto& track : tracks_) {
+        if (track.id == target_id_) {
+            return &track;
+        }
+    }
+    return nullptr;
+}
+
+cv::Point2f MultiTracker::predictAt(const Track& track, double timestamp) const {
+    for (size_t i = 0; i < tracks_.size(); ++i) {
+        if (tracks_[i].id != track.id) continue;
+
+        float dt = 0.0f;
+        if (timestamp >= 0.0 && last_timestamp_ >= 0.0) {
+            dt = static_cast<float>(timestamp - last_timestamp_);
+        }
+        return kf_.positionAfter(static_cast<int>(i), dt);
+    }
+    return track.predicted_position;
+}
+
+void MultiTracker::solvePoses(const PnPSolver& solver) {
+    cold_tracks_.clear();
+    cold_armors_.clear();
+    for (size_t i = 0; i < tracks_.size(); ++i) {
+        Track& track = tracks_[i];
+        if (track.detection < 0) {
+            // 位姿只对应本帧的观测；隔了丢失的帧也不再按帧间姿态变化外推
+            track.pose.valid = false;
+            track.last_pose.valid = false;
+            continue;
+        }
+        if (!track.pose.valid) {
+            // 没有参考姿态，与 solveTracked 的冷启动相同，攒到一起批量解算
+            cold_tracks_.push_back(static_cast<int>(i));
+            cold_armors_.push_back(track.armor);
+            continue;
+        }
+        solver.solveTracked(track.armor, track.pose, track.last_pose);
+    }
+
+    if (cold_armors_.empty()) return;
+    solver.solveBatch(cold_armors_, cold_poses_);
+    for (size_t k = 0; k < cold_tracks_.size(); ++k) {
+        Track& track = tracks_[cold_tracks_[k]];
+        track.last_pose.valid = false;
+        track.pose = cold_poses_[k];
+    }
+}
+
+cv::Rect MultiTracker::getSearchRoi(const cv::Size& image_size) const {
+    cv::Rect roi;
+    for (size_t i = 0; i < tracks_.size(); ++i) {
+        const Track& track = tracks_[i];
+        if (!track.isConfirmed() || track.armor.boundingRect.area() <= 0) continue;
+
+        // 与 Tracker::getSearchRoi 相同：按装甲板尺寸扩展，再加上丢失帧内可能移动的距离
+        cv::Point2f velocity = kf_.velocity(static_cast<int>(i));
+        float lookahead = last_dt_ * (track.lost_count + 1);
+        float half_w = track.armor.boundingRect.width * (0.5f + roi_scale_) + std::abs(velocity.x) * lookahead;
+        float half_h = track.armor.boundingRect.height * (0.5f + roi_scale_) + std::abs(velocity.y) * lookahead;
+
+        cv::Rect window(cvFloor(track.predicted_position.x - half_w), cvFloor(track.predicted_position.y - half_h),
+                        cvCeil(half_w * 2.0f), cvCeil(half_h * 2.0f));
+        roi = roi.area() > 0 ? (roi | window) : window;
+    }
+    return roi & cv::Rect(cv::Point(0, 0), image_size);
+}
+
+} // namespace rm_auto_aim
@@ -0,0 +1,485 @@
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include "armor_detector/pipeline.hpp"
+
+namespace rm_auto_aim {
+
+namespace {
+
+const char* kStageNames[Pipeline::STAGE_COUNT] = {"capture", "detect", "track", "output"};
+
+// 队列空/满时的退避：先让出时间片，多次未果后短暂休眠，避免空转占满核心
+void backoff(int& spins) {
+    if (++spins < 64) {
+        std::this_thread::yield();
+    } else {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+}
+
+} // namespace
+
+Pipeline::Pipeline(const DetectorParams& params, const PipelineConfig& config)
+    : config_(config),
+      detector_(params),
+      latency_(config.latency_smoothing, config.actuation_delay_s),
+      spin_observer_(config.fire_half_angle),
+      capture_queue_(config.queue_capacity),
+      detect_queue_(config.queue_capacity),
+      track_queue_(config.queue_capacity) {
+    // 三个队列各自装满，加上四个阶段各持有一帧
+    const std::size_t pool_size = capture_queue_.capacity() + detect_queue_.capacity() +
+                                  track_queue_.capacity() + STAGE_COUNT;
+    frames_.reserve(pool_size);
+    free_frames_.reserve(pool_size);
+    for (std::size_t i = 0; i < pool_size; ++i) {
+        frames_.emplace_back(new PipelineFrame());
+        free_frames_.push_back(frames_.back().get());
+    }
+
+    *config_.stats_out << "[PIPELINE] Initialized with " << pool_size << " pooled frames, queue capacity "
+              << config_.queue_capacity << (config_.drop_oldest ? ", drop-oldest" : ", blocking")
+              << std::endl;
+}
+
+Pipeline::~Pipeline() {
+    stop();
+}
+
+void Pipeline::setCameraParams(const cv::Mat& camera_matrix, const cv::Mat& dist_coeffs) {
+    pnp_solver_.setCameraParams(camera_matrix, dist_coeffs);
+    transformer_.setCameraMatrix(camera_matrix);
+    transformer_.setDistCoeffs(dist_coeffs);
+    pnp_enabled_ = !camera_matrix.empty();
+}
+
+void Pipeline::setImuBuffer(const ImuPoseBuffer* buffer, const CameraMount& mount) {
+    imu_buffer_ = buffer;
+    camera_mount_ = mount;
+}
+
+bool Pipeline::start(FrameSource source) {
+    if (running_.load() || !source) {
+        return false;
+    }
+
+    source_ = std::move(source);
+    capture_done_ = false;
+    detect_done_ = false;
+    track_done_ = false;
+    for (auto& counters : counters_) {
+        counters.processed = 0;
+        counters.dropped = 0;
+        counters.latency_sum_ns = 0;
+        counters.latency_max_ns = 0;
+    }
+    latency_.reset();
+    start_time_ = Clock::now();
+    running_ = true;
+
+    capture_thread_ = std::thread(&Pipeline::captureLoop, this);
+    detect_thread_ = std::thread(&Pipeline::detectLoop, this);
+    track_thread_ = std::thread(&Pipeline::trackLoop, this);
+    return true;
+}
+
+void Pipeline::stop() {
+    running_ = false;
+    if (capture_thread_.joinable()) capture_thread_.join();
+    if (detect_thread_.joinable()) detect_thread_.join();
+    if (track_thread_.joinable()) track_thread_.join();
+
+    // 回收仍在队列中的帧
+    PipelineFrame* frame = nullptr;
+    while (capture_queue_.tryPop(frame)) recycleFrame(frame);
+    while (detect_queue_.tryPop(frame)) recycleFrame(frame);
+    while (track_queue_.tryPop(frame)) recycleFrame(frame);
+}
+
+void Pipeline::captureLoop() {
+    std::uint64_t next_id = 0;
+
+    while (running_.load(std::memory_order_acquire)) {
+        PipelineFrame* frame = acquireFrame();
+        if (!frame) break;
+
+        // 采集阶段的计时起点放在读帧之前，包含解码/传输耗时
+        frame->capture_time = Clock::now();
+        frame->timestamp = std::chrono::duration<double>(frame->capture_time.time_since_epoch()).count();
+        if (!source_(frame->image, frame->timestamp) || frame->image.empty()) {
+            recycleFrame(frame);
+            break;
+        }
+        frame->id = next_id++;
+
+        record(CAPTURE, *frame);
+        push(capture_queue_, frame, CAPTURE);
+    }
+
+    capture_done_.store(true, std::memory_order_release);
+}
+
+void Pipeline::detectLoop() {
+    while (PipelineFrame* frame = pop(capture_queue_, capture_done_)) {
+        frame->detections = detector_.detectFrame(frame->image, getSearchRoi(), frame->timestamp);
+
+        record(DETECT, *frame);
+        push(detect_queue_, frame, DETECT);
+    }
+
+    detect_done_.store(true, std::memory_order_release);
+}
+
+void Pipeline::trackLoop() {
+    while (PipelineFrame* frame = pop(detect_queue_, detect_done_)) {
+        tracker_.setImageCenter(cv::Point2f(frame->image.cols * 0.5f, frame->image.rows * 0.5f));
+        tracker_.update(frame->detections->armors, frame->detections->timestamp);
+        // 下一帧的检测窗口；检测阶段可能已在处理后续帧，窗口最多滞后一到两帧
+        setSearchRoi(tracker_.getSearchRoi(frame->image.size()));
+        if (pnp_enabled_) {
+            tracker_.solvePoses(pnp_solver_);
+            checkReprojection();
+        }
+
+        TrackResult& result = frame->track;
+        result = TrackResult();
+        result.track_count = static_cast<int>(tracker_.getTracks().size());
+        // 曝光期间云台在转动：用本帧时间戳处插值的姿态，而不是最新的 IMU 采样
+        if (imu_buffer_ && frame->detections->timestamp >= 0.0) {
+            result.imu_valid = imu_buffer_->cameraToWorld(frame->detections->timestamp, camera_mount_,
+                                                          result.camera_to_world);
+        }
+
+        const Track* target = tracker_.getTarget();
+        result.has_target = (target != nullptr);
+        if (target) {
+            result.state = target->state;
+            result.target_id = target->id;
+            result.predicted_position = target->predicted_position;
+        }
+        // 只有本帧命中的轨迹才有位姿，丢失帧不输出上一次的结果
+        // 重投影误差过大的位姿（顶点检测错位、解错分支）同样不输出
+        const std::size_t target_index = target ? static_cast<std::size_t>(target - tracker_.getTracks().data()) : 0;
+        if (result.has_target && pnp_enabled_ && poseUsable(target_index)) {
+            const PnPResult& pose = target->pose;
+            result.pnp_valid = true;
+            result.rvec = pose.rvec;
+            result.tvec = pose.tvec;
+            result.reprojection_error = reprojection_errors_[target_index];
+            if (result.imu_valid) {
+                result.camera_to_world.transformPose(pose.rvec, pose.tvec, result.world_rvec, result.world_tvec);
+            }
+        }
+
+        if (target && pnp_enabled_) {
+            updateRobot(*frame, *target, result);
+        } else {
+            robot_ekf_.reset();
+            spin_observer_.reset();
+        }
+
+        // 本帧结果真正作用时目标已经移动：按平滑后的实测延迟加执行延迟外推
+        if (target) {
+            const double timestamp = frame->detections->timestamp;
+            result.lead_time_s = latency_.getLeadTime();
+            result.aim_position = timestamp >= 0.0
+                ? tracker_.predictAt(*target, timestamp + result.lead_time_s)
+                : target->predicted_position;
+            if (result.robot_valid && timestamp >= 0.0) {
+                result.spinning = spin_observer_.isSpinning();
+                result.spin_rate = spin_observer_.getSpinRate();
+
+                // 弹丸飞行期间目标继续运动：按上一次解出的飞行时间重新外推再解算。
+                // 自旋时不追单块装甲板，瞄准车体上正对相机的位置，等装甲板转入
+                cv::Point3f p;
+                for (int i = 0; i <= ballistic_iterations_; ++i) {
+                    const double t_hit = timestamp + result.lead_time_s + result.shot.flight_time;
+                    if (result.spinning) {
+                        p = SpinObserver::facingPoint(robot_ekf_, t_hit);
+                    } else {
+                        const auto plates = robot_ekf_.predictArmors(t_hit);
+                        p = plates[RobotEkf::facingArmor(plates)].position;
+                    }
+                    result.shot = ballistic_.solve(p, config_.bullet_speed);
+                    if (!result.shot.valid) break;
+                }
+                result.aim_valid = true;
+                result.aim_point = cv::Vec3d(p.x, p.y, p.z);
+
+                result.fire_window = spin_observer_.nextFireWindow(
+                    robot_ekf_, timestamp, result.lead_time_s + result.shot.flight_time);
+                result.fire_allowed = result.shot.valid &&
+                                      (!result.spinning || result.fire_window.contains(timestamp));
+            }
+        }
+
+        record(TRACK, *frame);
+        push(track_queue_, frame, TRACK);
+    }
+
+    track_done_.store(true, std::memory_order_release);
+}
+
+void Pipeline::checkReprojection() {
+    const std::vector<Track>& tracks = tracker_.getTracks();
+    reprojection_errors_.assign(tracks.size(), -1.0);
+    reprojection_points_.clear();
+    for (const Track& track : tracks) {
+        if (!track.pose.valid) continue;
+        cv::Matx33d rotation;
+        cv::Rodrigues(track.pose.rvec, rotation);
+        for (const cv::Point3f& corner : pnp_solver_.getObjectPoints(track.armor)) {
+            const cv::Vec3d p = rotation * cv::Vec3d(corner.x, corner.y, corner.z) + track.pose.tvec;
+            reprojection_points_.emplace_back(static_cast<float>(p[0]), static_cast<float>(p[1]),
+                                              static_cast<float>(p[2]));
+        }
+    }
+    if (reprojection_points_.empty()) return;
+
+    transformer_.worldToPixel(reprojection_points_, reprojection_pixels_);
+    const cv::Point2f* pixel = reprojection_pixels_.data();
+    for (std::size_t i = 0; i < tracks.size(); ++i) {
+        if (!tracks[i].pose.valid) continue;
+        double sum = 0.0;
+        for (const cv::Point2f& vertex : tracks[i].armor.vertices) {
+            const cv::Point2f d = *pixel++ - vertex;
+            sum += d.x * d.x + d.y * d.y;
+        }
+        reprojection_errors_[i] = std::sqrt(sum / 4.0);
+    }
+}
+
+bool Pipeline::observe(const cv::Vec3d& rvec, const cv::Vec3d& tvec, const TrackResult& result,
+                       ArmorObservation& obs) const {
+    if (!imu_buffer_) {
+        obs = RobotEkf::observationFromPnP(rvec, tvec);
+        return true;
+    }
+    // 整车状态在世界系中：查不到姿态的帧不能退回相机系观测
+    if (!result.imu_valid) {
+        return false;
+    }
+    cv::Vec3d world_rvec, world_tvec;
+    result.camera_to_world.transformPose(rvec, tvec, world_rvec, world_tvec);
+    obs = RobotEkf::observationFromWorld(world_rvec, world_tvec);
+    return true;
+}
+
+void Pipeline::updateRobot(const PipelineFrame& frame, const Track& target, TrackResult& result) {
+    const double timestamp = frame.detections->timestamp;
+    ArmorObservation target_obs;
+    const bool observed = result.pnp_valid && observe(result.rvec, result.tvec, result, target_obs);
+
+    robot_ekf_.predict(timestamp);
+    // 本帧该车辆上匹配到的装甲板中最大的轨迹编号，用于统计装甲板交接
+    std::uint32_t newest_plate = 0;
+
+    // 自旋时目标常在同一车辆的装甲板之间切换，此时沿用整车状态；换到另一辆车才重新初始化
+    if (robot_ekf_.isInitialized() && target.id != robot_target_id_) {
+        if (!observed || cv::norm(target_obs.position - robot_ekf_.getCenter()) >= robot_gate_) {
+            robot_ekf_.reset();
+            spin_observer_.reset();
+        }
+    }
+    robot_target_id_ = target.id;
+
+    if (!robot_ekf_.isInitialized()) {
+        if (!observed) {
+            return;
+        }
+        robot_ekf_.init(target_obs, timestamp);
+        newest_plate = target.id;
+    } else {
+        // 只用本帧实际匹配到的装甲板校正，丢失帧内只做预测
+        if (observed && target.lost_count == 0) {
+            robot_ekf_.update(target_obs);
+            newest_plate = target.id;
+        }
+
+        // 同一车辆上的其他可见装甲板（小陀螺时通常同时可见两块）
+        const std::vector<Track>& tracks = tracker_.getTracks();
+        for (std::size_t i = 0; i < tracks.size(); ++i) {
+            const Track& track = tracks[i];
+            if (track.id == target.id || !track.isConfirmed() || !poseUsable(i)) continue;
+            ArmorObservation obs;
+            if (!observe(track.pose.rvec, track.pose.tvec, result, obs)) continue;
+
+            if (cv::norm(obs.position - robot_ekf_.getCenter()) < robot_gate_) {
+                robot_ekf_.update(obs);
+                newest_plate = std::max(newest_plate, track.id);
+            }
+        }
+    }
+    spin_observer_.update(timestamp, newest_plate, robot_ekf_.getYawRate());
+
+    const cv::Point3f center = robot_ekf_.getCenter();
+    result.robot_valid = true;
+    result.robot_center = cv::Vec3d(center.x, center.y, center.z);
+    result.robot_yaw = robot_ekf_.getYaw();
+    result.robot_v_yaw = robot_ekf_.getYawRate();
+    result.robot_radius = robot_ekf_.getRadius();
+}
+
+void Pipeline::runOutput(FrameSink sink) {
+    Clock::time_point last_report = Clock::now();
+
+    while (PipelineFrame* frame = pop(track_queue_, track_done_)) {
+        bool keep_running = !sink || sink(*frame);
+        record(OUTPUT, *frame);
+        latency_.addSample(std::chrono::duration<double>(Clock::now() - frame->capture_time).count());
+        recycleFrame(frame);
+
+        if (config_.stats_interval_s > 0.0) {
+            Clock::time_point now = Clock::now();
+            if (std::chrono::duration<double>(now - last_report).count() >= config_.stats_interval_s) {
+                printStats();
+                last_report = now;
+            }
+        }
+
+        if (!keep_running) {
+            break;
+        }
+    }
+
+    stop();
+}
+
+void Pipeline::push(Queue& queue, PipelineFrame* frame, Stage stage) {
+    int spins = 0;
+    while (!queue.tryPush(frame)) {
+        if (config_.drop_oldest) {
+            // 丢弃最旧的帧，保证延迟有界；消费者恰好取走时重试即可
+            PipelineFrame* oldest = nullptr;
+            if (queue.dropOldest(oldest)) {
+                counters_[stage].dropped.fetch_add(1, std::memory_order_relaxed);
+                recycleFrame(oldest);
+            }
+        } else {
+            if (!running_.load(std::memory_order_acquire)) {
+                recycleFrame(frame);
+                return;
+            }
+            backoff(spins);
+        }
+    }
+}
+
+PipelineFrame* Pipeline::pop(Queue& queue, const std::atomic<bool>& upstream_done) {
+    PipelineFrame* frame = nullptr;
+    int spins = 0;
+    while (!queue.tryPop(frame)) {
+        // 先读结束标志再确认队列为空，避免漏掉上游结束前推入的最后几帧
+        if (upstream_done.load(std::memory_order_acquire) && queue.empty()) {
+            return nullptr;
+        }
+        if (!running_.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        backoff(spins);
+    }
+    return frame;
+}
+
+void Pipeline::record(Stage stage, const PipelineFrame& frame) {
+    StageCounters& counters = counters_[stage];
+    const std::uint64_t latency_ns = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - frame.capture_time).count());
+
+    // 每个阶段只有一个线程写入，读-改-写无需 CAS
+    counters.processed.fetch_add(1, std::memory_order_relaxed);
+    counters.latency_sum_ns.fetch_add(latency_ns, std::memory_order_relaxed);
+    if (latency_ns > counters.latency_max_ns.load(std::memory_order_relaxed)) {
+        counters.latency_max_ns.store(latency_ns, std::memory_order_relaxed);
+    }
+}
+
+PipelineFrame* Pipeline::acquireFrame() {
+    int spins = 0;
+    while (running_.load(std::memory_order_acquire)) {
+        {
+            std::lock_guard<std::mutex> lock(pool_mutex_);
+            if (!free_frames_.empty()) {
+                PipelineFrame* frame = free_frames_.back();
+                free_frames_.pop_back();
+                return frame;
+            }
+        }
+        // 阻塞模式下所有帧都可能在下游排队
+        backoff(spins);
+    }
+    return nullptr;
+}
+
+void Pipeline::recycleFrame(PipelineFrame* frame) {
+    // 释放检测结果句柄，结果帧回到检测器的帧池；图像缓冲保留以便复用
+    frame->detections.release();
+    std::lock_guard<std::mutex> lock(pool_mutex_);
+    free_frames_.push_back(frame);
+}
+
+void Pipeline::setSearchRoi(const cv::Rect& roi) {
+    std::uint64_t packed = 0;
+    if (roi.area() > 0) {
+        packed = (static_cast<std::uint64_t>(roi.x & 0xFFFF) << 48) |
+                 (static_cast<std::uint64_t>(roi.y & 0xFFFF) << 32) |
+                 (static_cast<std::uint64_t>(roi.width & 0xFFFF) << 16) |
+                 static_cast<std::uint64_t>(roi.height & 0xFFFF);
+    }
+    search_roi_.store(packed, std::memory_order_relaxed);
+}
+
+cv::Rect Pipeline::getSearchRoi() const {
+    const std::uint64_t packed = search_roi_.load(std::memory_order_relaxed);
+    return cv::Rect(static_cast<int>((packed >> 48) & 0xFFFF),
+                    static_cast<int>((packed >> 32) & 0xFFFF),
+                    static_cast<int>((packed >> 16) & 0xFFFF),
+                    static_cast<int>(packed & 0xFFFF));
+}
+
+std::array<Pipeline::StageStats, Pipeline::STAGE_COUNT> Pipeline::getStats() const {
+    std::array<StageStats, STAGE_COUNT> stats;
+    const double elapsed_s = std::chrono::duration<double>(Clock::now() - start_time_).count();
+
+    for (int i = 0; i < STAGE_COUNT; ++i) {
+        const StageCounters& counters = counters_[i];
+        StageStats& s = stats[i];
+        s.processed = counters.processed.load(std::memory_order_relaxed);
+        s.dropped = counters.dropped.load(std::memory_order_relaxed);
+        s.throughput_fps = elapsed_s > 0.0 ? s.processed / elapsed_s : 0.0;
+        if (s.processed > 0) {
+            s.mean_latency_ms = counters.latency_sum_ns.load(std::memory_order_relaxed) / 1e6 / s.processed;
+        }
+        s.max_latency_ms = counters.latency_max_ns.load(std::memory_order_relaxed) / 1e6;
+    }
+    return stats;
+}
+
+void Pipeline::printStats(std::ostream& os) const {
+    auto stats = getStats();
+    os << "[PIPELINE]";
+    for (int i = 0; i < STAGE_COUNT; ++i) {
+        os << " " << kStageNames[i] << ": " << std::fixed << std::setprecision(1)
+                  << stats[i].throughput_fps << " fps, "
+                  << std::setprecision(2) << stats[i].mean_latency_ms << "/"
+                  << stats[i].max_latency_ms << " ms";
+        if (stats[i].dropped > 0) {
+            os << ", " << stats[i].dropped << " dropped";
+        }
+        os << (i + 1 < STAGE_COUNT ? " |" : "");
+    }
+    os << std::endl;
+
+    const LatencyStats latency = getLatencyStats();
+    if (latency.samples > 0) {
+        os << "[LATENCY] last " << std::setprecision(2) << latency.last_ms
+           << " ms, smoothed " << latency.smoothed_ms
+           << " ms, mean/min/max " << latency.mean_ms << "/" << latency.min_ms << "/" << latency.max_ms
+           << " ms, actuation " << latency.actuation_delay_ms
+           << " ms, lead " << latency.lead_time_ms << " ms" << std::endl;
+    }
+}
+
+} // namespace rm_auto_aim
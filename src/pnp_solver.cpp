@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cmath>
 #include <opencv2/opencv.hpp>
 #include <opencv2/calib3d.hpp>
 #include "armor_detector/pnp_solver.hpp"
@@ -5,11 +7,231 @@
 
 namespace rm_auto_aim {
 
+namespace {
+
+// 3x3 矩阵（行优先）
+struct Mat3 {
+    double m[9];
+    double& operator()(int r, int c) { return m[r * 3 + c]; }
+    double operator()(int r, int c) const { return m[r * 3 + c]; }
+};
+
+// 把 (x, y, 1) 方向旋到 z 轴的旋转（IPPE 论文式 (30)），返回其转置，即 z 轴 -> (x, y, 1)
+Mat3 rotationZToVector(double x, double y) {
+    const double norm = std::sqrt(x * x + y * y + 1.0);
+    const double ax = x / norm, ay = y / norm, az = 1.0 / norm;
+    const double d = 1.0 / (1.0 + az);
+    Mat3 r;
+    r(0, 0) = 1.0 - ax * ax * d; r(0, 1) = -ax * ay * d;      r(0, 2) = ax;
+    r(1, 0) = -ax * ay * d;      r(1, 1) = 1.0 - ay * ay * d; r(1, 2) = ay;
+    r(2, 0) = -ax;               r(2, 1) = -ay;               r(2, 2) = 1.0 - (ax * ax + ay * ay) * d;
+    return r;
+}
+
+// IPPE：由单应在平面原点处的雅可比 J 与原点的像 (p, q) 求两组候选旋转（只需前两列）。
+// 返回 false 表示退化（雅可比奇异）
+bool ippeRotations(double j00, double j01, double j10, double j11, double p, double q,
+                   Mat3& r1, Mat3& r2) {
+    const Mat3 rv = rotationZToVector(p, q);
+
+    const double b00 = rv(0, 0) - p * rv(2, 0);
+    const double b01 = rv(0, 1) - p * rv(2, 1);
+    const double b10 = rv(1, 0) - q * rv(2, 0);
+    const double b11 = rv(1, 1) - q * rv(2, 1);
+    const double det = b00 * b11 - b01 * b10;
+    if (std::abs(det) < 1e-12) {
+        return false;
+    }
+
+    // A = B^-1 J
+    const double a00 = (b11 * j00 - b01 * j10) / det;
+    const double a01 = (b11 * j01 - b01 * j11) / det;
+    const double a10 = (-b10 * j00 + b00 * j10) / det;
+    const double a11 = (-b10 * j01 + b00 * j11) / det;
+
+    // A 的最大奇异值
+    const double ata00 = a00 * a00 + a01 * a01;
+    const double ata01 = a00 * a10 + a01 * a11;
+    const double ata11 = a10 * a10 + a11 * a11;
+    const double gamma2 = 0.5 * (ata00 + ata11 + std::sqrt((ata00 - ata11) * (ata00 - ata11) + 4.0 * ata01 * ata01));
+    if (!(gamma2 > 1e-24)) {
+        return false;
+    }
+    const double gamma = std::sqrt(gamma2);
+
+    const double t00 = a00 / gamma, t01 = a01 / gamma;
+    const double t10 = a10 / gamma, t11 = a11 / gamma;
+    const double c0 = std::sqrt(std::max(0.0, 1.0 - t00 * t00 - t10 * t10));
+    double c1 = std::sqrt(std::max(0.0, 1.0 - t01 * t01 - t11 * t11));
+    if (-t00 * t01 - t10 * t11 < 0.0) {
+        c1 = -c1;
+    }
+
+    // R = Rv * [t00 t01; t10 t11; +-c0 +-c1]，第三列为前两列的叉积
+    for (int k = 0; k < 2; ++k) {
+        Mat3& r = k == 0 ? r1 : r2;
+        const double s = k == 0 ? 1.0 : -1.0;
+        for (int i = 0; i < 3; ++i) {
+            r(i, 0) = t00 * rv(i, 0) + t10 * rv(i, 1) + s * c0 * rv(i, 2);
+            r(i, 1) = t01 * rv(i, 0) + t11 * rv(i, 1) + s * c1 * rv(i, 2);
+        }
+        r(0, 2) = r(1, 0) * r(2, 1) - r(2, 0) * r(1, 1);
+        r(1, 2) = r(2, 0) * r(0, 1) - r(0, 0) * r(2, 1);
+        r(2, 2) = r(0, 0) * r(1, 1) - r(1, 0) * r(0, 1);
+    }
+    return true;
+}
+
+// 已知旋转时平移的线性最小二乘解：x_i * (R U_i + t)_z = (R U_i + t)_x，y 同理
+bool planarTranslation(const Mat3& r, const double (&plane)[4][2], const cv::Point2d (&image)[4], cv::Vec3d& t) {
+    double ata[6] = {};   // 对称 3x3：00 01 02 11 12 22
+    double atb[3] = {};
+    for (int i = 0; i < 4; ++i) {
+        const double px = r(0, 0) * plane[i][0] + r(0, 1) * plane[i][1];
+        const double py = r(1, 0) * plane[i][0] + r(1, 1) * plane[i][1];
+        const double pz = r(2, 0) * plane[i][0] + r(2, 1) * plane[i][1];
+        const double x = image[i].x, y = image[i].y;
+        // 方程 [1 0 -x] t = x pz - px，[0 1 -y] t = y pz - py
+        const double bx = x * pz - px;
+        const double by = y * pz - py;
+        ata[0] += 1.0;
+        ata[2] += -x;
+        ata[3] += 1.0;
+        ata[4] += -y;
+        ata[5] += x * x + y * y;
+        atb[0] += bx;
+        atb[1] += by;
+        atb[2] += -x * bx - y * by;
+    }
+
+    const double m00 = ata[0], m01 = ata[1], m02 = ata[2], m11 = ata[3], m12 = ata[4], m22 = ata[5];
+    const double c00 = m11 * m22 - m12 * m12;
+    const double c01 = m02 * m12 - m01 * m22;
+    const double c02 = m01 * m12 - m02 * m11;
+    const double det = m00 * c00 + m01 * c01 + m02 * c02;
+    if (std::abs(det) < 1e-18) {
+        return false;
+    }
+    const double c11 = m00 * m22 - m02 * m02;
+    const double c12 = m01 * m02 - m00 * m12;
+    const double c22 = m00 * m11 - m01 * m01;
+    t[0] = (c00 * atb[0] + c01 * atb[1] + c02 * atb[2]) / det;
+    t[1] = (c01 * atb[0] + c11 * atb[1] + c12 * atb[2]) / det;
+    t[2] = (c02 * atb[0] + c12 * atb[1] + c22 * atb[2]) / det;
+    return t[2] > 0.0;
+}
+
+// 旋转向量 -> 旋转矩阵（Rodrigues）
+Mat3 vectorToRotation(const cv::Vec3d& rvec) {
+    const double theta = std::sqrt(rvec[0] * rvec[0] + rvec[1] * rvec[1] + rvec[2] * rvec[2]);
+    Mat3 r;
+    if (theta < 1e-12) {
+        // 一阶近似 I + [rvec]x
+        r(0, 0) = 1.0;      r(0, 1) = -rvec[2]; r(0, 2) = rvec[1];
+        r(1, 0) = rvec[2];  r(1, 1) = 1.0;      r(1, 2) = -rvec[0];
+        r(2, 0) = -rvec[1]; r(2, 1) = rvec[0];  r(2, 2) = 1.0;
+        return r;
+    }
+    const double kx = rvec[0] / theta, ky = rvec[1] / theta, kz = rvec[2] / theta;
+    const double c = std::cos(theta), s = std::sin(theta), v = 1.0 - c;
+    r(0, 0) = c + kx * kx * v;      r(0, 1) = kx * ky * v - kz * s; r(0, 2) = kx * kz * v + ky * s;
+    r(1, 0) = ky * kx * v + kz * s; r(1, 1) = c + ky * ky * v;      r(1, 2) = ky * kz * v - kx * s;
+    r(2, 0) = kz * kx * v - ky * s; r(2, 1) = kz * ky * v + kx * s; r(2, 2) = c + kz * kz * v;
+    return r;
+}
+
+Mat3 multiply(const Mat3& a, const Mat3& b) {
+    Mat3 c;
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            c(i, j) = a(i, 0) * b(0, j) + a(i, 1) * b(1, j) + a(i, 2) * b(2, j);
+        }
+    }
+    return c;
+}
+
+// 对称正定 6x6 方程组 A x = b 的 Cholesky 解，A 会被覆盖。对角线存倒数，只做 6 次除法
+bool solveSymmetric6(double (&a)[6][6], const double (&b)[6], double (&x)[6]) {
+    double inv[6];
+    for (int j = 0; j < 6; ++j) {
+        double d = a[j][j];
+        for (int k = 0; k < j; ++k) d -= a[j][k] * a[j][k];
+        if (!(d > 0.0)) {
+            return false;
+        }
+        inv[j] = 1.0 / std::sqrt(d);
+        for (int i = j + 1; i < 6; ++i) {
+            double v = a[i][j];
+            for (int k = 0; k < j; ++k) v -= a[i][k] * a[j][k];
+            a[i][j] = v * inv[j];
+        }
+    }
+    double y[6];
+    for (int i = 0; i < 6; ++i) {
+        double v = b[i];
+        for (int k = 0; k < i; ++k) v -= a[i][k] * y[k];
+        y[i] = v * inv[i];
+    }
+    for (int i = 5; i >= 0; --i) {
+        double v = y[i];
+        for (int k = i + 1; k < 6; ++k) v -= a[k][i] * x[k];
+        x[i] = v * inv[i];
+    }
+    return true;
+}
+
+// 板面坐标 (a, b) = 模型的 (y, z)，顶点顺序：左上、右上、右下、左下
+void plateCorners(ArmorType type, double (&plane)[4][2]) {
+    const bool small = type == ArmorType::SMALL;
+    const double half_w = (small ? PnPSolver::SMALL_ARMOR_WIDTH : PnPSolver::LARGE_ARMOR_WIDTH) / 2.0;
+    const double half_h = (small ? PnPSolver::SMALL_ARMOR_HEIGHT : PnPSolver::LARGE_ARMOR_HEIGHT) / 2.0;
+    plane[0][0] = -half_w; plane[0][1] = half_h;
+    plane[1][0] = half_w;  plane[1][1] = half_h;
+    plane[2][0] = half_w;  plane[2][1] = -half_h;
+    plane[3][0] = -half_w; plane[3][1] = -half_h;
+}
+
+// 旋转矩阵 -> 旋转向量（Rodrigues）
+cv::Vec3d rotationToVector(const Mat3& r) {
+    const double rx = r(2, 1) - r(1, 2);
+    const double ry = r(0, 2) - r(2, 0);
+    const double rz = r(1, 0) - r(0, 1);
+    const double s = 0.5 * std::sqrt(rx * rx + ry * ry + rz * rz);
+    const double c = std::min(std::max(0.5 * (r(0, 0) + r(1, 1) + r(2, 2) - 1.0), -1.0), 1.0);
+    const double theta = std::atan2(s, c);
+
+    if (s > 1e-5) {
+        const double k = theta / (2.0 * s);
+        return cv::Vec3d(rx * k, ry * k, rz * k);
+    }
+    if (c > 0.0) {
+        return cv::Vec3d(0.5 * rx, 0.5 * ry, 0.5 * rz);
+    }
+    // theta 接近 pi：R = 2 n n^T - I，从对角线最大的分量开始取旋转轴
+    int i = 0;
+    if (r(1, 1) > r(i, i)) i = 1;
+    if (r(2, 2) > r(i, i)) i = 2;
+    double n[3];
+    n[i] = std::sqrt(std::max(0.0, 0.5 * (r(i, i) + 1.0)));
+    for (int j = 0; j < 3; ++j) {
+        if (j != i) n[j] = (r(i, j) + r(j, i)) / (4.0 * n[i]);
+    }
+    return cv::Vec3d(n[0] * theta, n[1] * theta, n[2] * theta);
+}
+
+} // namespace
+
 PnPSolver::PnPSolver() {
     // 初始化3D世界点
     initWorldPoints();
 }
 
+void PnPSolver::setCameraParams(const cv::Mat& camera_matrix, const cv::Mat& dist_coeffs) {
+    camera_matrix_ = camera_matrix.clone();
+    dist_coeffs_ = dist_coeffs.clone();
+    model_.set(camera_matrix_, dist_coeffs_);
+}
+
 void PnPSolver::initWorldPoints() {
     // 单位：米
     
@@ -51,8 +273,8 @@ bool PnPSolver::solvePnP(const Armor& armor, cv::Mat& rvec, cv::Mat& tvec) {
     // 准备2D图像点
     std::vector<cv::Point2f> image_points;
     
-    // 确保装甲板有4个顶点
-    if (armor.vertices.size() != 4) {
+    // 确保装甲板有效（顶点固定为4个）
+    if (!armor.isValid()) {
         std::cerr << "[ERROR] Armor must have exactly 4 vertices!" << std::endl;
         return false;
     }
@@ -88,6 +310,293 @@ bool PnPSolver::solvePnP(const Armor& armor, cv::Mat& rvec, cv::Mat& tvec) {
     return success;
 }
 
+bool PnPSolver::solvePlanar(const Armor& armor, PnPResult& result) const {
+    return solvePlanar(armor, result, nullptr);
+}
+
+bool PnPSolver::solvePlanar(const Armor& armor, PnPResult& result, const double* reference) const {
+    result.valid = false;
+    if (model_.fx <= 0.0 || model_.fy <= 0.0 || !armor.isValid()) {
+        return false;
+    }
+    
+    double plane[4][2];
+    plateCorners(armor.type, plane);
+    const double half_w = plane[1][0], half_h = plane[1][1];
+    
+    cv::Point2d image[4];
+    for (int i = 0; i < 4; ++i) {
+        image[i] = model_.undistortNormalized(armor.vertices[i]);
+    }
+    
+    // 单位正方形 -> 四边形的单应（Heckbert 闭式解），四个顶点依次对应 (0,0) (1,0) (1,1) (0,1)
+    const double x0 = image[0].x, y0 = image[0].y, x1 = image[1].x, y1 = image[1].y;
+    const double x2 = image[2].x, y2 = image[2].y, x3 = image[3].x, y3 = image[3].y;
+    const double sx = x0 - x1 + x2 - x3;
+    const double sy = y0 - y1 + y2 - y3;
+    const double dx1 = x1 - x2, dx2 = x3 - x2, dy1 = y1 - y2, dy2 = y3 - y2;
+    const double den = dx1 * dy2 - dx2 * dy1;
+    if (std::abs(den) < 1e-15) {
+        return false;
+    }
+    const double g = (sx * dy2 - dx2 * sy) / den;
+    const double h = (dx1 * sy - sx * dy1) / den;
+    const double hs[9] = {x1 - x0 + g * x1, x3 - x0 + h * x3, x0,
+                          y1 - y0 + g * y1, y3 - y0 + h * y3, y0,
+                          g,                h,                1.0};
+    
+    // 复合板面 -> 单位正方形：s = a / (2w) + 0.5，t = -b / (2h) + 0.5
+    const double sa = 1.0 / (2.0 * half_w), sb = -1.0 / (2.0 * half_h);
+    double hm[9];
+    for (int r = 0; r < 3; ++r) {
+        hm[r * 3 + 0] = hs[r * 3 + 0] * sa;
+        hm[r * 3 + 1] = hs[r * 3 + 1] * sb;
+        hm[r * 3 + 2] = 0.5 * (hs[r * 3 + 0] + hs[r * 3 + 1]) + hs[r * 3 + 2];
+    }
+    if (std::abs(hm[8]) < 1e-15) {
+        return false;
+    }
+    for (double& v : hm) {
+        v /= hm[8];
+    }
+    
+    // 板中心的像与该处的雅可比
+    const double p = hm[2], q = hm[5];
+    const double j00 = hm[0] - hm[6] * p, j01 = hm[1] - hm[7] * p;
+    const double j10 = hm[3] - hm[6] * q, j11 = hm[4] - hm[7] * q;
+    
+    Mat3 candidates[2];
+    if (!ippeRotations(j00, j01, j10, j11, p, q, candidates[0], candidates[1])) {
+        return false;
+    }
+    
+    // 两组候选各求平移，取归一化平面上重投影误差较小的
+    int best = -1;
+    double best_error = 0.0;
+    double errors[2] = {-1.0, -1.0};
+    cv::Vec3d translations[2];
+    for (int k = 0; k < 2; ++k) {
+        const Mat3& r = candidates[k];
+        if (!planarTranslation(r, plane, image, translations[k])) continue;
+        
+        const cv::Vec3d& t = translations[k];
+        double error = 0.0;
+        for (int i = 0; i < 4; ++i) {
+            const double px = r(0, 0) * plane[i][0] + r(0, 1) * plane[i][1] + t[0];
+            const double py = r(1, 0) * plane[i][0] + r(1, 1) * plane[i][1] + t[1];
+            const double pz = r(2, 0) * plane[i][0] + r(2, 1) * plane[i][1] + t[2];
+            const double ex = px / pz - image[i].x, ey = py / pz - image[i].y;
+            error += ex * ex + ey * ey;
+        }
+        errors[k] = error;
+        if (best < 0 || error < best_error) {
+            best = k;
+            best_error = error;
+        }
+    }
+    if (best < 0) {
+        return false;
+    }
+    
+    // 板面系 (a, b, n) -> 模型系 (x = n, y = a, z = b)
+    Mat3 models[2];
+    for (int k = 0; k < 2; ++k) {
+        for (int i = 0; i < 3; ++i) {
+            models[k](i, 0) = candidates[k](i, 2);
+            models[k](i, 1) = candidates[k](i, 0);
+            models[k](i, 2) = candidates[k](i, 1);
+        }
+    }
+    
+    // 两组解都能解释观测（误差在噪声量级内）时无法只凭本帧区分，取与参考姿态更接近的一组
+    const int other = 1 - best;
+    const double ambiguous = ambiguity_ratio_ * best_error + 4.0 * ambiguity_pixels_ * ambiguity_pixels_ / (model_.fx * model_.fy);
+    if (reference && errors[other] >= 0.0 && errors[other] <= ambiguous) {
+        double similarity[2];
+        for (int k = 0; k < 2; ++k) {
+            similarity[k] = 0.0;
+            for (int i = 0; i < 9; ++i) {
+                similarity[k] += reference[i] * models[k].m[i];   // trace(R_ref^T R_k)
+            }
+        }
+        if (similarity[other] > similarity[best]) {
+            best = other;
+        }
+    }
+    const Mat3& rm = models[best];
+    
+    result.rvec = rotationToVector(rm);
+    result.tvec = translations[best];
+    result.reprojection_error = reprojectionError(armor, rm.m, result.tvec);
+    result.valid = true;
+    return true;
+}
+
+bool PnPSolver::refinePlanar(const Armor& armor, PnPResult& pose, int iterations) const {
+    if (model_.fx <= 0.0 || model_.fy <= 0.0 || !armor.isValid() || !pose.valid) {
+        return false;
+    }
+    
+    double plane[4][2];
+    plateCorners(armor.type, plane);
+    cv::Point2d image[4];
+    for (int i = 0; i < 4; ++i) {
+        image[i] = model_.undistortNormalized(armor.vertices[i]);
+    }
+    
+    // 残差取归一化平面上的投影误差乘以焦距（近似像素），参数为左乘的旋转增量与平移增量
+    Mat3 r = vectorToRotation(pose.rvec);
+    cv::Vec3d t = pose.tvec;
+    auto cost = [&](const Mat3& rot, const cv::Vec3d& trans, double (&residual)[8]) {
+        double sum = 0.0;
+        for (int i = 0; i < 4; ++i) {
+            const double x = rot(0, 1) * plane[i][0] + rot(0, 2) * plane[i][1] + trans[0];
+            const double y = rot(1, 1) * plane[i][0] + rot(1, 2) * plane[i][1] + trans[1];
+            const double z = rot(2, 1) * plane[i][0] + rot(2, 2) * plane[i][1] + trans[2];
+            if (!(z > 0.0)) {
+                return -1.0;
+            }
+            residual[2 * i] = model_.fx * (x / z - image[i].x);
+            residual[2 * i + 1] = model_.fy * (y / z - image[i].y);
+            sum += residual[2 * i] * residual[2 * i] + residual[2 * i + 1] * residual[2 * i + 1];
+        }
+        return sum;
+    };
+    
+    double residual[8];
+    double current = cost(r, t, residual);
+    if (current < 0.0) {
+        return false;
+    }
+    
+    double lambda = 1e-3;
+    for (int it = 0; it < iterations; ++it) {
+        // J^T J 与 J^T r；旋转增量 w 左乘：dX/dw = -[R P]x，dX/dt = I
+        double jtj[6][6] = {};
+        double jtr[6] = {};
+        for (int i = 0; i < 4; ++i) {
+            const double rx = r(0, 1) * plane[i][0] + r(0, 2) * plane[i][1];
+            const double ry = r(1, 1) * plane[i][0] + r(1, 2) * plane[i][1];
+            const double rz = r(2, 1) * plane[i][0] + r(2, 2) * plane[i][1];
+            const double x = rx + t[0], y = ry + t[1], z = rz + t[2];
+            const double iz = 1.0 / z;
+            
+            // 投影对 X 的雅可比（已乘焦距）
+            const double pu[3] = {model_.fx * iz, 0.0, -model_.fx * x * iz * iz};
+            const double pv[3] = {0.0, model_.fy * iz, -model_.fy * y * iz * iz};
+            // -[RP]x 的三列
+            const double dw[3][3] = {{0.0, rz, -ry}, {-rz, 0.0, rx}, {ry, -rx, 0.0}};
+            
+            double ju[6], jv[6];
+            for (int k = 0; k < 3; ++k) {
+                ju[k] = pu[0] * dw[0][k] + pu[1] * dw[1][k] + pu[2] * dw[2][k];
+                jv[k] = pv[0] * dw[0][k] + pv[1] * dw[1][k] + pv[2] * dw[2][k];
+                ju[k + 3] = pu[k];
+                jv[k + 3] = pv[k];
+            }
+            for (int a = 0; a < 6; ++a) {
+                jtr[a] += ju[a] * residual[2 * i] + jv[a] * residual[2 * i + 1];
+                for (int b = 0; b <= a; ++b) {
+                    jtj[a][b] += ju[a] * ju[b] + jv[a] * jv[b];
+                }
+            }
+        }
+        
+        // LM：每次迭代只解一次，代价上升时拒绝该步并加大阻尼
+        double a[6][6];
+        double neg[6];
+        for (int i = 0; i < 6; ++i) {
+            for (int j = 0; j <= i; ++j) {
+                a[i][j] = a[j][i] = jtj[i][j];
+            }
+            a[i][i] += lambda * jtj[i][i] + 1e-12;
+            neg[i] = -jtr[i];
+        }
+        double delta[6];
+        if (!solveSymmetric6(a, neg, delta)) {
+            break;
+        }
+        
+        const Mat3 candidate_r = multiply(vectorToRotation(cv::Vec3d(delta[0], delta[1], delta[2])), r);
+        const cv::Vec3d candidate_t(t[0] + delta[3], t[1] + delta[4], t[2] + delta[5]);
+        double candidate_residual[8];
+        const double candidate = cost(candidate_r, candidate_t, candidate_residual);
+        if (candidate >= 0.0 && candidate < current) {
+            r = candidate_r;
+            t = candidate_t;
+            current = candidate;
+            std::copy(std::begin(candidate_residual), std::end(candidate_residual), std::begin(residual));
+            lambda = std::max(lambda * 0.1, 1e-7);
+        } else {
+            lambda *= 10.0;
+        }
+    }
+    
+    pose.rvec = rotationToVector(r);
+    pose.tvec = t;
+    pose.reprojection_error = reprojectionError(armor, r.m, t);
+    return true;
+}
+
+bool PnPSolver::solveTracked(const Armor& armor, PnPResult& pose, PnPResult& last_pose) const {
+    // 参考姿态：按最近两帧的姿态变化匀速外推到本帧
+    const PnPResult previous = pose;
+    Mat3 reference;
+    if (previous.valid) {
+        reference = vectorToRotation(previous.rvec);
+        if (last_pose.valid) {
+            const Mat3 last = vectorToRotation(last_pose.rvec);
+            Mat3 step;   // R_prev * R_last^T
+            for (int i = 0; i < 3; ++i) {
+                for (int j = 0; j < 3; ++j) {
+                    step(i, j) = reference(i, 0) * last(j, 0) + reference(i, 1) * last(j, 1) + reference(i, 2) * last(j, 2);
+                }
+            }
+            reference = multiply(step, reference);
+        }
+    }
+    
+    last_pose = previous;
+    if (!solvePlanar(armor, pose, previous.valid ? reference.m : nullptr)) {
+        last_pose.valid = false;
+        return false;
+    }
+    if (previous.valid && warm_iterations_ > 0) {
+        refinePlanar(armor, pose, warm_iterations_);
+    }
+    return true;
+}
+
+double PnPSolver::reprojectionError(const Armor& armor, const double* rotation, const cv::Vec3d& tvec) const {
+    double plane[4][2];
+    plateCorners(armor.type, plane);
+    
+    // 像素重投影误差（含畸变），模型点 (0, a, b) 只用到旋转的第 2、3 列
+    double sum = 0.0;
+    for (int i = 0; i < 4; ++i) {
+        const double px = rotation[1] * plane[i][0] + rotation[2] * plane[i][1] + tvec[0];
+        const double py = rotation[4] * plane[i][0] + rotation[5] * plane[i][1] + tvec[1];
+        const double pz = rotation[7] * plane[i][0] + rotation[8] * plane[i][1] + tvec[2];
+        const cv::Point2d pixel = model_.projectNormalized(px / pz, py / pz);
+        const double ex = pixel.x - armor.vertices[i].x, ey = pixel.y - armor.vertices[i].y;
+        sum += ex * ex + ey * ey;
+    }
+    return std::sqrt(sum / 4.0);
+}
+
+int PnPSolver::solveBatch(const std::vector<Armor>& armors, std::vector<PnPResult>& results) const {
+    results.resize(armors.size());
+    int solved = 0;
+    for (size_t i = 0; i < armors.size(); ++i) {
+        solved += solvePlanar(armors[i], results[i]) ? 1 : 0;
+    }
+    return solved;
+}
+
+const std::vector<cv::Point3f>& PnPSolver::getObjectPoints(const Armor& armor) const {
+    return (armor.type == ArmorType::SMALL) ? small_armor_points_ : large_armor_points_;
+}
+
 float PnPSolver::calculateDistanceToCenter(const cv::Point2f& image_point) {
     if (camera_matrix_.empty()) {
         std::cerr << "[ERROR] Camera matrix not set!" << std::endl;
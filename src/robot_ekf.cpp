@@ -0,0 +1,246 @@
+#include <algorithm>
+#include <cmath>
+#include "armor_detector/robot_ekf.hpp"
+
+namespace rm_auto_aim
+{
+
+namespace
+{
+constexpr float kPi = 3.14159265358979f;
+constexpr float kArmorStep = kPi / 2.0f;  // 相邻装甲板的朝向间隔
+}  // namespace
+
+RobotEkf::RobotEkf()
+{
+  // 只测量位置与朝向，H 在每次校正时按当前状态重建
+  kf_.measurementMatrix = Filter::MeasMatrix::zeros();
+  kf_.errorCovPost = Filter::StateMatrix::identity();
+  setTransition(0.01f);
+}
+
+void RobotEkf::setTransition(float dt)
+{
+  // 匀速 + 匀角速模型，半径为常量
+  kf_.transitionMatrix = Filter::StateMatrix::identity();
+  kf_.transitionMatrix(0, 1) = dt;
+  kf_.transitionMatrix(2, 3) = dt;
+  kf_.transitionMatrix(4, 5) = dt;
+  kf_.transitionMatrix(6, 7) = dt;
+
+  // 分段白噪声加速度：[dt^4/4, dt^3/2; dt^3/2, dt^2] * sigma^2
+  const float t2 = dt * dt;
+  const float t3 = t2 * dt;
+  const float t4 = t3 * dt;
+  kf_.processNoiseCov = Filter::StateMatrix::zeros();
+  const int pairs[4] = {0, 2, 4, 6};
+  for (int p : pairs) {
+    const float s2 = (p == 6) ? sigma2QYaw_ : sigma2QXyz_;
+    kf_.processNoiseCov(p, p) = t4 / 4.0f * s2;
+    kf_.processNoiseCov(p, p + 1) = t3 / 2.0f * s2;
+    kf_.processNoiseCov(p + 1, p) = t3 / 2.0f * s2;
+    kf_.processNoiseCov(p + 1, p + 1) = t2 * s2;
+  }
+  kf_.processNoiseCov(8, 8) = t4 / 4.0f * sigma2QR_;
+}
+
+void RobotEkf::init(const ArmorObservation& armor, double timestamp)
+{
+  const float r = initialRadius_;
+  kf_.statePost = Filter::StateVector::zeros();
+  kf_.statePost[0] = armor.position.x - r * std::cos(armor.yaw);
+  kf_.statePost[2] = armor.position.y - r * std::sin(armor.yaw);
+  kf_.statePost[4] = armor.position.z;
+  kf_.statePost[6] = armor.yaw;
+  kf_.statePost[8] = r;
+  kf_.errorCovPost = Filter::StateMatrix::identity();
+  kf_.statePre = kf_.statePost;
+  kf_.errorCovPre = kf_.errorCovPost;
+
+  initialized_ = true;
+  last_timestamp_ = timestamp;
+}
+
+void RobotEkf::predict(double timestamp)
+{
+  if (!initialized_) return;
+
+  if (timestamp >= 0.0 && last_timestamp_ >= 0.0) {
+    const float dt = std::min(std::max(static_cast<float>(timestamp - last_timestamp_), minDt_), maxDt_);
+    setTransition(dt);
+    kf_.predict();
+  }
+  if (timestamp >= 0.0) {
+    last_timestamp_ = timestamp;
+  }
+}
+
+int RobotEkf::assignArmor(float yaw_a) const
+{
+  const float yaw = kf_.statePost[6];
+  int best = 0;
+  float best_diff = kPi * 2.0f;
+  for (int k = 0; k < kArmorCount; ++k) {
+    const float expected = yaw + k * kArmorStep;
+    const float diff = std::abs(unwrapAngle(yaw_a, expected) - expected);
+    if (diff < best_diff) {
+      best_diff = diff;
+      best = k;
+    }
+  }
+  return best;
+}
+
+int RobotEkf::update(const ArmorObservation& armor)
+{
+  if (!initialized_) return -1;
+
+  // 在上一次校正后的状态处线性化（同一帧内多块装甲板依次校正）
+  kf_.statePre = kf_.statePost;
+  kf_.errorCovPre = kf_.errorCovPost;
+
+  const int k = assignArmor(armor.yaw);
+  const auto& x = kf_.statePre;
+  const float a = x[6] + k * kArmorStep;
+  const float r = x[8];
+  const float cos_a = std::cos(a);
+  const float sin_a = std::sin(a);
+
+  // h(x) 及其雅可比
+  Filter::MeasVector h;
+  h[0] = x[0] + r * cos_a;
+  h[1] = x[2] + r * sin_a;
+  h[2] = x[4];
+  h[3] = a;
+
+  auto& H = kf_.measurementMatrix;
+  H = Filter::MeasMatrix::zeros();
+  H(0, 0) = 1.0f;
+  H(0, 6) = -r * sin_a;
+  H(0, 8) = cos_a;
+  H(1, 2) = 1.0f;
+  H(1, 6) = r * cos_a;
+  H(1, 8) = sin_a;
+  H(2, 4) = 1.0f;
+  H(3, 6) = 1.0f;
+
+  kf_.measurementNoiseCov = Filter::MeasCovMatrix::zeros();
+  kf_.measurementNoiseCov(0, 0) = rXyzFactor_ * std::abs(armor.position.x) + 1e-6f;
+  kf_.measurementNoiseCov(1, 1) = rXyzFactor_ * std::abs(armor.position.y) + 1e-6f;
+  kf_.measurementNoiseCov(2, 2) = rXyzFactor_ * std::abs(armor.position.z) + 1e-6f;
+  kf_.measurementNoiseCov(3, 3) = rYaw_;
+
+  // correct() 的新息为 z - H x'，传入 z - h(x') + H x' 即得到 EKF 新息 z - h(x')
+  const float z[4] = {armor.position.x, armor.position.y, armor.position.z, unwrapAngle(armor.yaw, a)};
+  Filter::MeasVector measurement;
+  for (int i = 0; i < 4; ++i) {
+    double hx = 0.0;
+    for (int j = 0; j < 9; ++j) {
+      hx += static_cast<double>(H(i, j)) * x[j];
+    }
+    measurement[i] = static_cast<float>(z[i] - h[i] + hx);
+  }
+  kf_.correct(measurement);
+
+  // 半径只在合理范围内变化；朝向保持在 [-pi, pi]，避免持续自旋时 float 精度下降
+  kf_.statePost[8] = std::min(std::max(kf_.statePost[8], minRadius_), maxRadius_);
+  kf_.statePost[6] = unwrapAngle(kf_.statePost[6], 0.0f);
+  return k;
+}
+
+std::array<ArmorObservation, RobotEkf::kArmorCount> RobotEkf::predictArmors(double timestamp) const
+{
+  const auto& x = kf_.statePost;
+  float dt = 0.0f;
+  if (timestamp >= 0.0 && last_timestamp_ >= 0.0) {
+    dt = std::min(static_cast<float>(timestamp - last_timestamp_), maxDt_);
+  }
+
+  const float xc = x[0] + x[1] * dt;
+  const float yc = x[2] + x[3] * dt;
+  const float za = x[4] + x[5] * dt;
+  const float yaw = x[6] + x[7] * dt;
+
+  std::array<ArmorObservation, kArmorCount> armors;
+  for (int k = 0; k < kArmorCount; ++k) {
+    const float a = yaw + k * kArmorStep;
+    armors[k].position = cv::Point3f(xc + x[8] * std::cos(a), yc + x[8] * std::sin(a), za);
+    armors[k].yaw = a;
+  }
+  return armors;
+}
+
+int RobotEkf::facingArmor(const std::array<ArmorObservation, kArmorCount>& armors)
+{
+  // 外法向与“装甲板指向原点”的水平方向夹角最小者，即 cos 值最大
+  int best = 0;
+  float best_cos = -2.0f;
+  for (int k = 0; k < kArmorCount; ++k) {
+    const cv::Point3f& p = armors[k].position;
+    const float dist = std::sqrt(p.x * p.x + p.y * p.y);
+    if (dist <= 0.0f) continue;
+    const float cos_k = -(p.x * std::cos(armors[k].yaw) + p.y * std::sin(armors[k].yaw)) / dist;
+    if (cos_k > best_cos) {
+      best_cos = cos_k;
+      best = k;
+    }
+  }
+  return best;
+}
+
+cv::Point3f RobotEkf::getCenter() const
+{
+  return cv::Point3f(kf_.statePost[0], kf_.statePost[2], kf_.statePost[4]);
+}
+
+cv::Point3f RobotEkf::getVelocity() const
+{
+  return cv::Point3f(kf_.statePost[1], kf_.statePost[3], kf_.statePost[5]);
+}
+
+ArmorObservation RobotEkf::observationFromPnP(const cv::Vec3d& rvec, const cv::Vec3d& tvec)
+{
+  // 旋转矩阵第一列 = 模型 x 轴（装甲板外法向）在相机系下的方向（Rodrigues 公式）
+  const double theta = std::sqrt(rvec[0] * rvec[0] + rvec[1] * rvec[1] + rvec[2] * rvec[2]);
+  // 朝向只需要水平分量（相机系 x、z）
+  double nx = 1.0, nz = 0.0;
+  if (theta > 1e-12) {
+    const double kx = rvec[0] / theta, ky = rvec[1] / theta, kz = rvec[2] / theta;
+    const double c = std::cos(theta), s = std::sin(theta);
+    nx = c + (1.0 - c) * kx * kx;
+    nz = (1.0 - c) * kx * kz - s * ky;
+  }
+
+  // 相机光学系 (x 右, y 下, z 前) -> 世界系 (x 前, y 左, z 上)
+  ArmorObservation obs;
+  obs.position = cv::Point3f(static_cast<float>(tvec[2]), static_cast<float>(-tvec[0]),
+                             static_cast<float>(-tvec[1]));
+  obs.yaw = static_cast<float>(std::atan2(-nx, nz));
+  return obs;
+}
+
+ArmorObservation RobotEkf::observationFromWorld(const cv::Vec3d& rvec, const cv::Vec3d& tvec)
+{
+  // 同上，取旋转矩阵第一列的水平分量（世界系 x、y）
+  const double theta = std::sqrt(rvec[0] * rvec[0] + rvec[1] * rvec[1] + rvec[2] * rvec[2]);
+  double nx = 1.0, ny = 0.0;
+  if (theta > 1e-12) {
+    const double kx = rvec[0] / theta, ky = rvec[1] / theta, kz = rvec[2] / theta;
+    const double c = std::cos(theta), s = std::sin(theta);
+    nx = c + (1.0 - c) * kx * kx;
+    ny = (1.0 - c) * kx * ky + s * kz;
+  }
+
+  ArmorObservation obs;
+  obs.position = cv::Point3f(static_cast<float>(tvec[0]), static_cast<float>(tvec[1]),
+                             static_cast<float>(tvec[2]));
+  obs.yaw = static_cast<float>(std::atan2(ny, nx));
+  return obs;
+}
+
+float RobotEkf::unwrapAngle(float a, float reference)
+{
+  return reference + std::remainder(a - reference, 2.0f * kPi);
+}
+
+}  // namespace rm_auto_aim
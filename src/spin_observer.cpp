@@ -0,0 +1,103 @@
+#include <cmath>
+#include "armor_detector/spin_observer.hpp"
+
+namespace rm_auto_aim {
+
+namespace {
+
+constexpr double kHalfPi = 1.57079632679489662;
+
+} // namespace
+
+SpinObserver::SpinObserver(double fire_half_angle)
+    : fire_half_angle_(fire_half_angle) {
+}
+
+void SpinObserver::reset() {
+    newest_id_ = 0;
+    last_handoff_ = -1.0;
+    last_update_ = -1.0;
+    interval_ = 0.0;
+    handoff_count_ = 0;
+    spin_rate_ = 0.0;
+}
+
+void SpinObserver::update(double timestamp, std::uint32_t newest_plate_id, double yaw_rate) {
+    last_update_ = timestamp;
+
+    if (newest_plate_id > newest_id_) {
+        const double dt = last_handoff_ >= 0.0 ? timestamp - last_handoff_ : -1.0;
+        newest_id_ = newest_plate_id;
+
+        if (dt < 0.0) {
+            // 第一块装甲板
+            handoff_count_ = 1;
+            last_handoff_ = timestamp;
+        } else if (dt < min_interval_ || (handoff_count_ >= min_handoffs_ && dt < 0.5 * interval_)) {
+            // 同一装甲板的轨迹断开后重建，不算交接
+        } else if (dt > max_interval_) {
+            // 间隔过长，重新计数
+            handoff_count_ = 1;
+            interval_ = 0.0;
+            last_handoff_ = timestamp;
+        } else if (handoff_count_ == 1) {
+            // 第一块装甲板可能是转到一半才看到的，从第一次交接开始计时
+            handoff_count_ = 2;
+            last_handoff_ = timestamp;
+        } else {
+            // 中间漏掉的交接按整数倍折算
+            double sample = dt;
+            if (handoff_count_ >= min_handoffs_ && dt > 1.5 * interval_) {
+                sample = dt / std::round(dt / interval_);
+            }
+            interval_ = handoff_count_ > 2 ? interval_ + smoothing_ * (sample - interval_) : sample;
+            handoff_count_++;
+            last_handoff_ = timestamp;
+        }
+    }
+
+    spin_rate_ = interval_ > 0.0 ? std::copysign(kHalfPi / interval_, yaw_rate) : 0.0;
+}
+
+bool SpinObserver::isSpinning() const {
+    return handoff_count_ >= min_handoffs_ && interval_ > 0.0 &&
+           last_update_ - last_handoff_ <= 2.0 * interval_ + 0.1;
+}
+
+cv::Point3f SpinObserver::facingPoint(const RobotEkf& robot, double timestamp) {
+    const auto plates = robot.predictArmors(timestamp);
+    const float r = robot.getRadius();
+    const float cx = plates[0].position.x - r * std::cos(plates[0].yaw);
+    const float cy = plates[0].position.y - r * std::sin(plates[0].yaw);
+    const float dist = std::sqrt(cx * cx + cy * cy);
+    if (dist <= 0.0f) {
+        return plates[0].position;
+    }
+    return cv::Point3f(cx - r * cx / dist, cy - r * cy / dist, plates[0].position.z);
+}
+
+FireWindow SpinObserver::nextFireWindow(const RobotEkf& robot, double timestamp, double delay) const {
+    FireWindow window;
+    if (!isSpinning() || !robot.isInitialized()) {
+        return window;
+    }
+
+    const auto plates = robot.predictArmors(timestamp + delay);
+    const float r = robot.getRadius();
+    const double cx = plates[0].position.x - r * std::cos(plates[0].yaw);
+    const double cy = plates[0].position.y - r * std::sin(plates[0].yaw);
+    const double facing = std::atan2(-cy, -cx);
+
+    // 最近一块装甲板沿转动方向相对正对方向的相位，[-pi/4, pi/4]；已转过窗口时等下一块
+    const double omega = std::abs(spin_rate_);
+    const double phase = (spin_rate_ >= 0.0 ? 1.0 : -1.0) * std::remainder(plates[0].yaw - facing, kHalfPi);
+    const double to_center = (phase > fire_half_angle_ ? kHalfPi - phase : -phase) / omega;
+    const double half = fire_half_angle_ / omega;
+
+    window.valid = true;
+    window.open_time = timestamp + to_center - half;
+    window.close_time = timestamp + to_center + half;
+    return window;
+}
+
+} // namespace rm_auto_aim
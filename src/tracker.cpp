@@ -1,33 +1,46 @@
 #include <cmath>
 #include <algorithm>
 #include <iostream>
+#include <limits>
 #include "armor_detector/tracker.hpp"
+#include "armor_detector/imm_filter.hpp"
+#include "armor_detector/kalman_filter.hpp"
 
 namespace rm_auto_aim {
 
-Tracker::Tracker() {
-    kf_ = std::make_unique<KalmanFilter>();
+Tracker::Tracker(FilterType filter_type) {
+    if (filter_type == IMM_FILTER) {
+        kf_ = std::make_unique<ImmKalmanFilter>();
+    } else {
+        kf_ = std::make_unique<KalmanFilter>();
+    }
     reset();
 }
 
 void Tracker::reset() {
     state_ = LOST;
     is_tracking_ = false;
-    tracked_armor_ = nullptr;
+    has_tracked_armor_ = false;
+    last_armor_rect_ = cv::Rect();
+    last_timestamp_ = -1.0;
     detect_count_ = 0;
     lost_count_ = 0;
 }
 
-void Tracker::init(const Armor& armor) {
+void Tracker::init(const Armor& armor, double timestamp) {
     if (!armor.isValid()) {
         reset();
         return;
     }
     
     // 初始化卡尔曼滤波器
-    kf_->init(armor.center);
+    kf_->init(armor.center, timestamp);
+    last_timestamp_ = timestamp;
     
-    tracked_armor_ = &armor;
+    tracked_armor_ = armor;
+    has_tracked_armor_ = true;
+    last_armor_rect_ = armor.boundingRect;
+    predicted_position_ = armor.center;
     detect_count_ = 1;
     lost_count_ = 0;
     state_ = DETECTING;
@@ -37,62 +50,114 @@ void Tracker::init(const Armor& armor) {
               << armor.center.x << ", " << armor.center.y << std::endl;
 }
 
+bool InnovationGate::set(float s00, float s01, float s11) {
+    const float det = s00 * s11 - s01 * s01;
+    if (!(det > 0.0f)) {
+        return false;
+    }
+    inv_s00 = s11 / det;
+    inv_s01 = -s01 / det;
+    inv_s11 = s00 / det;
+    return true;
+}
+
+void Tracker::updateGate() {
+    // S = H P H^T + R，再加上匀速模型未覆盖的机动（各向同性）
+    const cv::Matx22f s = kf_->getInnovationCov();
+    const float motion = gate_motion_std_ * gate_motion_std_;
+    if (!gate_.set(s(0, 0) + motion, s(0, 1), s(1, 1) + motion)) {
+        gate_ = InnovationGate();
+    }
+}
+
 const Armor* Tracker::selectBestMatch(const std::vector<Armor>& armors) {
-    if (armors.empty() || !is_tracking_) {
+    if (armors.empty() || !has_tracked_armor_) {
         return nullptr;
     }
     
-    // 如果有跟踪的装甲板，选择匹配度最高的
+    updateGate();
+    
+    // 门限内匹配代价最小的装甲板
     const Armor* best_match = nullptr;
     float best_score = std::numeric_limits<float>::max();
     
     for (const auto& armor : armors) {
         if (!armor.isValid()) continue;
         
-        float score = calculateMatchScore(armor);
-        if (score < best_score) {
+        float score = matchScore(tracked_armor_, predicted_position_, gate_, gate_chi2_, armor);
+        if (score >= 0.0f && score < best_score) {
             best_score = score;
             best_match = &armor;
         }
     }
     
-    // 检查是否满足匹配条件
-    if (best_match && best_score < max_match_distance_) {
-        return best_match;
-    }
-    
-    return nullptr;
+    return best_match;
 }
 
-float Tracker::calculateMatchScore(const Armor& armor) {
-    if (!is_tracking_ || !tracked_armor_) {
+float Tracker::sizePenalty(const Armor& tracked, const Armor& armor) {
+    // 宽为上下两条边的平均长度，高为左右两条边的平均长度
+    auto width = [](const Armor& a) {
+        return 0.5f * (cv::norm(a.vertices[1] - a.vertices[0]) + cv::norm(a.vertices[2] - a.vertices[3]));
+    };
+    auto height = [](const Armor& a) {
+        return 0.5f * (cv::norm(a.vertices[3] - a.vertices[0]) + cv::norm(a.vertices[2] - a.vertices[1]));
+    };
+    
+    const float w0 = width(tracked), w1 = width(armor);
+    const float h0 = height(tracked), h1 = height(armor);
+    if (std::min(w0, w1) <= 0.0f || std::min(h0, h1) <= 0.0f) {
         return std::numeric_limits<float>::max();
     }
     
-    // 计算位置差异
-    cv::Point2f pred_pos = predicted_position_;
-    cv::Point2f curr_pos = armor.center;
-    
-    float distance = cv::norm(pred_pos - curr_pos);
+    float width_ratio = std::max(w0, w1) / std::min(w0, w1);
+    float height_ratio = std::max(h0, h1) / std::min(h0, h1);
+    return std::max(width_ratio, height_ratio);
+}
+
+float Tracker::matchScore(const Armor& tracked, const cv::Point2f& predicted,
+                          const InnovationGate& gate, float gate_chi2, const Armor& armor) {
+    // 先做门限判断，门外的候选不再计算尺寸差异
+    float distance2 = gate.distance2(armor.center - predicted);
+    if (!(distance2 <= gate_chi2)) {
+        return -1.0f;
+    }
     
-    // 计算尺寸差异
-    float width_ratio = std::max(armor.vertices[1].x - armor.vertices[0].x, 
-                                tracked_armor_->vertices[1].x - tracked_armor_->vertices[0].x) /
-                       std::min(armor.vertices[1].x - armor.vertices[0].x, 
-                                tracked_armor_->vertices[1].x - tracked_armor_->vertices[0].x);
+    float size_penalty = sizePenalty(tracked, armor);
     
-    float height_ratio = std::max(armor.vertices[2].y - armor.vertices[1].y,
-                                 tracked_armor_->vertices[2].y - tracked_armor_->vertices[1].y) /
-                        std::min(armor.vertices[2].y - armor.vertices[1].y,
-                                 tracked_armor_->vertices[2].y - tracked_armor_->vertices[1].y);
+    // 综合评分（位置差异为主，尺寸差异为辅）
+    return distance2 * (1.0f + 0.1f * (size_penalty - 1.0f));
+}
+
+cv::Rect Tracker::getSearchRoi(const cv::Size& image_size) const {
+    if ((state_ != TRACKING && state_ != TEMP_LOST) || last_armor_rect_.area() <= 0) {
+        return cv::Rect();
+    }
     
-    float size_penalty = std::max(width_ratio, height_ratio);
+    // 窗口以预测位置为中心：四周按上次装甲板尺寸扩展，
+    // 再加上按卡尔曼速度估计、在丢失帧数内可能移动的距离
+    cv::Point2f velocity = kf_->getVelocity();
+    float lookahead = kf_->getDt() * (lost_count_ + 1);
+    float half_w = last_armor_rect_.width * (0.5f + roi_scale_) + std::abs(velocity.x) * lookahead;
+    float half_h = last_armor_rect_.height * (0.5f + roi_scale_) + std::abs(velocity.y) * lookahead;
     
-    // 综合评分（位置差异为主，尺寸差异为辅）
-    return distance * (1.0f + 0.1f * (size_penalty - 1.0f));
+    cv::Rect roi(cvFloor(predicted_position_.x - half_w), cvFloor(predicted_position_.y - half_h),
+                 cvCeil(half_w * 2.0f), cvCeil(half_h * 2.0f));
+    return roi & cv::Rect(cv::Point(0, 0), image_size);
 }
 
-void Tracker::update(const std::vector<Armor>& armors) {
+cv::Point2f Tracker::predictAt(double timestamp) const {
+    if (state_ != TRACKING && state_ != TEMP_LOST) {
+        return predicted_position_;
+    }
+    return kf_->predictAt(timestamp);
+}
+
+void Tracker::update(const std::vector<Armor>& armors, double timestamp) {
+    if (timestamp < 0.0) {
+        timestamp = last_timestamp_ >= 0.0 ? last_timestamp_ + nominal_frame_interval_ : -1.0;
+    }
+    last_timestamp_ = timestamp;
+    
     switch (state_) {
         case LOST:
             if (!armors.empty()) {
@@ -110,17 +175,22 @@ void Tracker::update(const std::vector<Armor>& armors) {
                     }
                 }
                 
-                init(*closest_armor);
+                init(*closest_armor, timestamp);
             }
             break;
             
         case DETECTING:
+            // 与 TRACKING 相同：先预测，门限以本帧的预测位置为中心
+            predicted_position_ = kf_->predict(timestamp);
+            
             if (!armors.empty()) {
                 const Armor* match = selectBestMatch(armors);
                 if (match) {
                     detect_count_++;
-                    tracked_armor_ = match;
+                    tracked_armor_ = *match;
+                    last_armor_rect_ = match->boundingRect;
                     kf_->update(match->center);
+                    predicted_position_ = kf_->getPrediction();
                     
                     if (detect_count_ >= tracking_thres_) {
                         state_ = TRACKING;
@@ -139,13 +209,14 @@ void Tracker::update(const std::vector<Armor>& armors) {
             
         case TRACKING:
             // 先进行预测
-            predicted_position_ = kf_->predict();
+            predicted_position_ = kf_->predict(timestamp);
             
             if (!armors.empty()) {
                 const Armor* match = selectBestMatch(armors);
                 if (match) {
                     // 找到匹配，更新滤波器
-                    tracked_armor_ = match;
+                    tracked_armor_ = *match;
+                    last_armor_rect_ = match->boundingRect;
                     kf_->update(match->center);
                     lost_count_ = 0;
                     
@@ -171,13 +242,14 @@ void Tracker::update(const std::vector<Armor>& armors) {
             
         case TEMP_LOST:
             // 仍然进行预测
-            predicted_position_ = kf_->predict();
+            predicted_position_ = kf_->predict(timestamp);
             
             if (!armors.empty()) {
                 const Armor* match = selectBestMatch(armors);
                 if (match) {
                     // 重新找到目标，恢复跟踪
-                    tracked_armor_ = match;
+                    tracked_armor_ = *match;
+                    last_armor_rect_ = match->boundingRect;
                     kf_->update(match->center);
                     lost_count_ = 0;
                     state_ = TRACKING;